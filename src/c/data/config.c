@@ -2,9 +2,11 @@
 #include "../data/frontable_cache.h"
 #include "../menus/current_fronters_menu.h"
 #include "../menus/custom_fronts_menu.h"
+#include "../menus/frontable_menu.h"
 #include "../menus/main_menu.h"
 #include "../menus/members_menu.h"
 #include "../menus/settings_menu.h"
+#include "persistence.h"
 
 #define SETTINGS_KEY 1
 
@@ -24,9 +26,13 @@ static void set_defaults() {
     settings.show_pronouns = true;
     settings.show_time_fronting = true;
     strncpy(settings.custom_front_text, "[custom]", sizeof(settings.custom_front_text));
+    settings.sort_order = SORT_ORDER_NAME;
 }
 
-static void apply(bool update_colors) {
+void settings_apply(bool update_colors) {
+    // compact mode, pronouns, labels etc all change row layouts
+    frontable_menu_invalidate_layouts();
+
     if (update_colors) {
         main_menu_update_colors();
         members_menu_update_colors();
@@ -68,10 +74,14 @@ ClaySettings* settings_get() {
 void settings_load() {
     set_defaults();
     persist_read_data(SETTINGS_KEY, &settings, sizeof(ClaySettings));
-    apply(true);
+    settings_apply(true);
 }
 
 void settings_save(bool update_colors) {
+    persistence_mark_settings_dirty();
+    settings_apply(update_colors);
+}
+
+void settings_store() {
     persist_write_data(SETTINGS_KEY, &settings, sizeof(ClaySettings));
-    apply(update_colors);
 }
@@ -3,6 +3,15 @@
 #include "../frontables/frontable.h"
 #include <pebble.h>
 
+// orders the watch can show lists in without asking the phone,
+//   name is whatever order the phone sent
+typedef enum {
+    SORT_ORDER_NAME,
+    SORT_ORDER_FRONTING,
+    SORT_ORDER_COLOR,
+    SORT_ORDER_COUNT
+} SortOrder;
+
 typedef struct {
     GColor accent_color;
     GColor background_color;
@@ -17,10 +26,15 @@ typedef struct {
     bool show_pronouns;
     bool show_time_fronting;
     char custom_front_text[FRONTABLE_PRONOUNS_LENGTH];
+
+    // watch-only, appended so older stored settings still load
+    uint8_t sort_order;
 } ClaySettings;
 
 ClaySettings* settings_get();
 GColor settings_get_global_accent();
 
 void settings_load();
+void settings_apply(bool update_colors);
 void settings_save(bool update_colors);
+void settings_store();
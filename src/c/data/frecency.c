@@ -0,0 +1,219 @@
+#include "frecency.h"
+#include "frontable_cache.h"
+#include "persistence.h"
+
+// sits right after the cache slot keys
+#define FRECENCY_KEY 60
+#define FRECENCY_FORMAT_VERSION 1
+
+// every use adds this much, and scores halve every half life.
+//   a member used daily overtakes one used a lot a month ago
+#define SCORE_PER_USE 64
+#define HALF_LIFE_SECONDS (3 * 24 * 60 * 60)
+
+typedef struct {
+    // ids move around between syncs, the name check catches that
+    uint16_t id;
+    uint16_t name_check;
+    uint16_t score;
+    uint32_t last_used;
+} __attribute__((__packed__)) FrecencyEntry;
+
+typedef struct {
+    uint8_t version;
+    uint8_t num_entries;
+    FrecencyEntry entries[FRECENCY_MAX_ENTRIES];
+} __attribute__((__packed__)) FrecencyTable;
+
+// kept sorted by score, highest first, so reading the top is free
+static FrecencyTable table = {
+    .version = FRECENCY_FORMAT_VERSION,
+    .num_entries = 0
+};
+
+static uint16_t get_name_check(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619u;
+    }
+
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+static uint16_t get_decayed_score(const FrecencyEntry* entry, uint32_t now) {
+    uint32_t age = now > entry->last_used ? now - entry->last_used : 0;
+    uint32_t half_lives = age / HALF_LIFE_SECONDS;
+    if (half_lives >= 16) return 0;
+
+    return entry->score >> half_lives;
+}
+
+// moves one entry up to where it belongs, the rest stay sorted
+static void bubble_up(uint8_t index, uint32_t now) {
+    while (index > 0) {
+        FrecencyEntry* above = &table.entries[index - 1];
+        FrecencyEntry* entry = &table.entries[index];
+        if (get_decayed_score(entry, now) <= get_decayed_score(above, now)) break;
+
+        FrecencyEntry temp = *above;
+        *above = *entry;
+        *entry = temp;
+        index--;
+    }
+}
+
+static void remove_entry(uint8_t index) {
+    for (uint8_t i = index + 1; i < table.num_entries; i++) {
+        table.entries[i - 1] = table.entries[i];
+    }
+
+    table.num_entries--;
+}
+
+void frecency_record_use(const Frontable* frontable) {
+    uint32_t now = time(NULL);
+    uint16_t name_check = get_name_check(frontable->name);
+
+    int16_t index = -1;
+    for (uint8_t i = 0; i < table.num_entries; i++) {
+        if (table.entries[i].id == frontable->id && table.entries[i].name_check == name_check) {
+            index = i;
+            break;
+        }
+    }
+
+    uint32_t score = SCORE_PER_USE;
+    if (index >= 0) {
+        score += get_decayed_score(&table.entries[index], now);
+    } else if (table.num_entries < FRECENCY_MAX_ENTRIES) {
+        index = table.num_entries;
+        table.num_entries++;
+    } else {
+        // the table is sorted, so the last entry is the least likely one
+        index = table.num_entries - 1;
+    }
+
+    table.entries[index] = (FrecencyEntry) {
+        .id = frontable->id,
+        .name_check = name_check,
+        .score = score > UINT16_MAX ? UINT16_MAX : score,
+        .last_used = now
+    };
+
+    bubble_up(index, now);
+    persistence_mark_frecency_dirty();
+}
+
+static bool contains(Frontable** frontables, uint8_t count, const Frontable* frontable) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (frontables[i] == frontable) return true;
+    }
+
+    return false;
+}
+
+uint8_t frecency_get_top(Frontable** out, uint8_t max) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < table.num_entries && count < max; i++) {
+        Frontable* frontable = cache_get_frontable(table.entries[i].id);
+        if (frontable != NULL && !contains(out, count, frontable)) {
+            out[count++] = frontable;
+        }
+    }
+
+    return count;
+}
+
+static Frontable* find_by_name_check(FrontableList* list, uint16_t name_check) {
+    for (uint16_t i = 0; i < list->num_stored; i++) {
+        if (get_name_check(list->frontables[i]->name) == name_check) {
+            return list->frontables[i];
+        }
+    }
+
+    return NULL;
+}
+
+// remapping can point two entries at one frontable (an id that was
+//   already taken, or names that collide), keep the higher score
+static void merge_duplicates() {
+    uint32_t now = time(NULL);
+
+    for (uint8_t i = 0; i < table.num_entries; i++) {
+        bool merged = false;
+
+        for (int16_t j = table.num_entries - 1; j > i; j--) {
+            if (table.entries[j].id != table.entries[i].id) continue;
+
+            if (get_decayed_score(&table.entries[j], now) > get_decayed_score(&table.entries[i], now)) {
+                table.entries[i] = table.entries[j];
+                merged = true;
+            }
+            remove_entry(j);
+        }
+
+        if (merged) {
+            bubble_up(i, now);
+        }
+    }
+}
+
+void frecency_remap() {
+    bool changed = false;
+
+    for (int16_t i = table.num_entries - 1; i >= 0; i--) {
+        FrecencyEntry* entry = &table.entries[i];
+
+        Frontable* frontable = cache_get_frontable(entry->id);
+        if (frontable != NULL && get_name_check(frontable->name) == entry->name_check) {
+            continue;
+        }
+
+        // id was given to someone else, look for the frontable by name
+        frontable = find_by_name_check(cache_get_members(), entry->name_check);
+        if (frontable == NULL) {
+            frontable = find_by_name_check(cache_get_custom_fronts(), entry->name_check);
+        }
+
+        if (frontable != NULL) {
+            entry->id = frontable->id;
+        } else {
+            remove_entry(i);
+        }
+
+        changed = true;
+    }
+
+    if (changed) {
+        merge_duplicates();
+        persistence_mark_frecency_dirty();
+    }
+}
+
+void frecency_load() {
+    if (!persist_exists(FRECENCY_KEY)) return;
+
+    FrecencyTable loaded;
+    int size = persist_read_data(FRECENCY_KEY, &loaded, sizeof(FrecencyTable));
+
+    // only one format so far, anything else just starts over. a short
+    //   record would leave entries past what was read uninitialized
+    if (
+        size < (int)(sizeof(uint8_t) * 2) ||
+        loaded.version != FRECENCY_FORMAT_VERSION ||
+        loaded.num_entries > FRECENCY_MAX_ENTRIES ||
+        size != (int)(sizeof(uint8_t) * 2 + sizeof(FrecencyEntry) * loaded.num_entries)
+    ) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Frecency data unreadable, starting fresh!");
+        return;
+    }
+
+    table = loaded;
+}
+
+void frecency_store() {
+    // only write the entries in use
+    size_t size = sizeof(uint8_t) * 2 + sizeof(FrecencyEntry) * table.num_entries;
+    persist_write_data(FRECENCY_KEY, &table, size);
+}
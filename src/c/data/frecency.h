@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../frontables/frontable.h"
+#include <pebble.h>
+
+#define FRECENCY_MAX_ENTRIES 8
+
+/// @brief Bumps the frecency score of a frontable, call whenever it's set or added to front
+/// @param frontable Frontable that was used
+void frecency_record_use(const Frontable* frontable);
+
+/// @brief Gets the highest scoring frontables, most likely first
+/// @param out Array to write frontable pointers into
+/// @param max Max number of frontables to write
+/// @return Number of frontables written
+uint8_t frecency_get_top(Frontable** out, uint8_t max);
+
+/// @brief Re-resolves scored frontables after a sync re-assigned ids, dropping ones that are gone
+void frecency_remap();
+
+/// @brief Loads scores from persistent storage
+void frecency_load();
+
+/// @brief Writes scores to persistent storage
+void frecency_store();
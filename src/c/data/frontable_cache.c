@@ -1,17 +1,38 @@
 #include "frontable_cache.h"
+#include "config.h"
+#include "memory_governor.h"
+#include "../menus/frontable_menu.h"
+#include "../tools/heap_stats.h"
 #include "../tools/string_tools.h"
-
-#define PRONOUNS_KEY 2
-#define FRONTABLES_NUM_KEY 3
-#define FRONTABLES_KEY_MIN 4
-#define FRONTABLES_KEY_MAX 20
-#define GROUPS_NUM_KEY 21
-#define GROUPS_KEY_MIN 22
-#define GROUPS_KEY_MAX 30
+#include "../tools/trace.h"
+
+// legacy layout (format version 0), chunks used to be overwritten in
+//   place. only read now, migrated forward so older installs keep their cache
+#define LEGACY_PRONOUNS_KEY 2
+#define LEGACY_FRONTABLES_NUM_KEY 3
+#define LEGACY_FRONTABLES_KEY_MIN 4
+#define LEGACY_FRONTABLES_KEY_MAX 20
+#define LEGACY_GROUPS_NUM_KEY 21
+#define LEGACY_GROUPS_KEY_MIN 22
+#define LEGACY_GROUPS_KEY_MAX 30
+#define LEGACY_MAX_CACHED_FRONTABLES 96
+
+// the cache alternates between two slots, each slot is a header key
+//   followed by chunk keys holding one packed byte stream. the header
+//   is written last, so a slot only becomes valid once fully stored
+#define CACHE_SLOT_COUNT 2
+#define CACHE_SLOT_KEY_BASE 40
+#define CACHE_SLOT_KEY_STRIDE 10
+#define CACHE_SLOT_MAX_CHUNKS 8
+#define CACHE_SLOT_MAX_BYTES 1920
+#define CACHE_SLOT_HEADER_KEY(slot) (CACHE_SLOT_KEY_BASE + ((slot) * CACHE_SLOT_KEY_STRIDE))
+#define CACHE_SLOT_CHUNK_KEY(slot, chunk) (CACHE_SLOT_HEADER_KEY(slot) + 1 + (chunk))
+
+// bump this whenever the slot stream layout changes, and add a
+//   migration from the previous version to CACHE_MIGRATIONS below
+#define CACHE_FORMAT_VERSION 2
 
 // tweak these to adjust how much memory is allocated
-// #define MAX_CACHED_FRONTABLES 64
-#define MAX_CACHED_FRONTABLES 96
 #define MAX_CACHED_PRONOUNS 16
 #define MAX_CACHED_GROUPS GROUP_LIST_MAX_COUNT
 #define COMPRESSED_NAME_LENGTH 20
@@ -22,42 +43,60 @@
 #define GROUP_QUEUE_SIZE GROUP_LIST_MAX_COUNT
 #define CURRENT_FRONTER_QUEUE_SIZE 100
 
-// ~~~ current memory footprint ~~~
-//
-// max memory taken up by pronoun map:
-//   MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH) == 176 bytes
+// ~~~ current storage footprint ~~~
 //
-// max memory taken up by frontables:
-//   sizeof(CompressedFrontable) * MAX_CACHED_FRONTABLES == 3072 bytes
-//   ^ this should equate to 12 chunks stored
+// apps only get 4kb of persistent storage in total, so each slot is
+//   capped at CACHE_SLOT_MAX_BYTES == 1920 bytes (8 chunks). both slots
+//   plus their headers come out to 3872 bytes, leaving room for settings
+//   and the frecency table (82 bytes at most, see frecency.c)
 //
-// max memory taken up by groups:
-//   sizeof(CompressedGroup) * MAX_CACHED_GROUPS == 704 bytes
+// records are packed with variable length strings (a length byte
+//   followed by the characters), so how many fit depends on names:
+//   pronouns:   1 + up to 10 bytes each
+//   groups:     3 + up to 19 bytes each
+//   frontables: 9 + up to 19 bytes each
 //
-// total memory footprint: 3952 bytes <3
+// frontables that don't fit in a slot are left out of the stored cache <3
 
-typedef struct CompressedFrontable {
+typedef struct LegacyCompressedFrontable {
     char name[COMPRESSED_NAME_LENGTH];
     uint32_t hash;
     uint32_t group_bit_field;
     uint8_t pronoun_index;
     uint8_t packed_data;
-} CompressedFrontable;
+} LegacyCompressedFrontable;
 
-typedef struct CompressedGroup {
+typedef struct LegacyCompressedGroup {
     char name[COMPRESSED_NAME_LENGTH];
     uint8_t color;
     uint8_t parent_index;
-} CompressedGroup;
+} LegacyCompressedGroup;
+
+typedef struct CacheSlotHeader {
+    uint32_t generation;
+    uint32_t checksum;
+    uint16_t length;
+    uint16_t num_frontables;
+    uint8_t num_groups;
+    uint8_t num_pronouns;
+    uint8_t version;
+} CacheSlotHeader;
+
+typedef struct CacheStream {
+    uint8_t* data;
+    uint16_t length;
+    uint16_t capacity;
+    uint16_t cursor;
+} CacheStream;
 
 typedef struct CurrentFrontData {
-    uint32_t hash;
+    uint16_t id;
     uint32_t start_time;
 } CurrentFrontData;
 
 // TODO: command cache for frontable tracking for when phone gets disconnected
 // typedef struct {
-//     uint32_t hash;
+//     uint16_t id;
 //     time_t time;
 //     uint8_t type;
 // } Command;
@@ -85,34 +124,42 @@ Frontable* cache_get_first_fronter() {
     return NULL;
 }
 
-Frontable* cache_get_frontable(uint32_t hash) {
-    //! using just iteration to search isn't the best idea...
-    //!   for the future, since we have hashes for each frontable:
-    //!   make a hash map maybe !!!!
-    // TODO: implement a hash map for frontable lookup
+Frontable* cache_get_frontable(uint16_t id) {
+    // ids are positions in the list the phone sent (custom fronts
+    //   first, then members), so they index straight into the lists
+    Frontable* frontable = NULL;
+    if (id < custom_fronts.num_stored) {
+        frontable = custom_fronts.frontables[id];
+    } else if (id - custom_fronts.num_stored < members.num_stored) {
+        frontable = members.frontables[id - custom_fronts.num_stored];
+    }
 
-    for (uint32_t i = 0; i < members.num_stored; i++) {
-        Frontable* member = members.frontables[i];
-        if (member->hash == hash) {
-            return member;
+    if (frontable != NULL && frontable->id == id) {
+        return frontable;
+    }
+
+    //! only happens if the phone ever sends fronts out of order,
+    //!   fall back to searching so lookups still resolve
+    for (uint16_t i = 0; i < custom_fronts.num_stored; i++) {
+        if (custom_fronts.frontables[i]->id == id) {
+            return custom_fronts.frontables[i];
         }
     }
 
-    for (uint32_t i = 0; i < custom_fronts.num_stored; i++) {
-        Frontable* custom_front = custom_fronts.frontables[i];
-        if (custom_front->hash == hash) {
-            return custom_front;
+    for (uint16_t i = 0; i < members.num_stored; i++) {
+        if (members.frontables[i]->id == id) {
+            return members.frontables[i];
         }
     }
 
     return NULL;
 }
 
-void cache_add_frontable(Frontable* frontable) {
+bool cache_add_frontable(Frontable* frontable) {
     if (frontable_get_is_custom(frontable)) {
-        frontable_list_add(frontable, &custom_fronts);
+        return frontable_list_add(frontable, &custom_fronts);
     } else {
-        frontable_list_add(frontable, &members);
+        return frontable_list_add(frontable, &members);
     }
 }
 
@@ -121,10 +168,10 @@ void cache_clear_frontables() {
     frontable_list_deep_clear(&custom_fronts);
 }
 
-void cache_add_current_fronter(uint32_t hash, uint32_t start_time) {
-    Frontable* frontable = cache_get_frontable(hash);
-    frontable->time_started_fronting = start_time;
+void cache_add_current_fronter(uint16_t id, uint32_t start_time) {
+    Frontable* frontable = cache_get_frontable(id);
     if (frontable != NULL) {
+        frontable->time_started_fronting = start_time;
         frontable_set_is_fronting(frontable, true);
         frontable_list_add(frontable, &current_fronters);
     }
@@ -167,7 +214,7 @@ void cache_queue_add_frontable(Frontable* frontable) {
     }
 
     if (frontable_queue == NULL) {
-        frontable_queue = malloc(sizeof(Frontable*) * FRONTABLE_QUEUE_SIZE);
+        frontable_queue = heap_stats_malloc(HEAP_TAG_QUEUES, sizeof(Frontable*) * FRONTABLE_QUEUE_SIZE);
     }
 
     frontable_queue[frontable_queue_count] = frontable;
@@ -181,38 +228,212 @@ void cache_queue_add_group(Group* group) {
     }
 
     if (group_queue == NULL) {
-        group_queue = malloc(sizeof(Group*) * GROUP_QUEUE_SIZE);
+        group_queue = heap_stats_malloc(HEAP_TAG_QUEUES, sizeof(Group*) * GROUP_QUEUE_SIZE);
     }
 
     group_queue[group_queue_count] = group;
     group_queue_count++;
 }
 
-void cache_queue_add_current_fronter(uint32_t hash, uint32_t start_time) {
+void cache_queue_add_current_fronter(uint16_t id, uint32_t start_time) {
     if (current_fronter_queue_count >= CURRENT_FRONTER_QUEUE_SIZE) {
         APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Cannot add to current fronter queue, max count has been reached!");
         return;
     }
 
     if (current_fronter_queue == NULL) {
-        current_fronter_queue = malloc(sizeof(CurrentFrontData) * CURRENT_FRONTER_QUEUE_SIZE);
+        current_fronter_queue = heap_stats_malloc(HEAP_TAG_QUEUES, sizeof(CurrentFrontData) * CURRENT_FRONTER_QUEUE_SIZE);
     }
 
     current_fronter_queue[current_fronter_queue_count] = (CurrentFrontData) {
-        .hash = hash,
+        .id = id,
         .start_time = start_time
     };
 
     current_fronter_queue_count++;
 }
 
+// ~~~ SORT ORDERS ~~~
+//
+// other orders are kept as ranks indexed by frontable id, lists are
+//   then shown through a permutation sorted by those ranks so nothing
+//   has to be re-sent or moved. name order is the order the phone
+//   sent, aka the id itself, so it doesn't need an array
+
+// 30 degree hue steps, with grays after every colored bucket
+#define COLOR_HUE_BUCKETS 12
+#define COLOR_SORT_BUCKETS (COLOR_HUE_BUCKETS + 1)
+
+static uint16_t* sort_ranks[SORT_ORDER_COUNT] = {NULL};
+static uint16_t num_ranked = 0;
+
+// frontables in the order the phone sent them, custom fronts first
+static Frontable* get_sent_frontable(uint16_t position) {
+    if (position < custom_fronts.num_stored) {
+        return custom_fronts.frontables[position];
+    }
+
+    return members.frontables[position - custom_fronts.num_stored];
+}
+
+static uint8_t get_color_key(GColor color) {
+    int16_t r = (color.argb >> 4) & 0b11;
+    int16_t g = (color.argb >> 2) & 0b11;
+    int16_t b = color.argb & 0b11;
+
+    int16_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    int16_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    int16_t delta = max - min;
+    if (delta == 0) return COLOR_HUE_BUCKETS;
+
+    int16_t hue;
+    if (max == r) {
+        hue = (60 * (g - b)) / delta;
+    } else if (max == g) {
+        hue = 120 + (60 * (b - r)) / delta;
+    } else {
+        hue = 240 + (60 * (r - g)) / delta;
+    }
+    if (hue < 0) hue += 360;
+
+    return (hue * COLOR_HUE_BUCKETS) / 360;
+}
+
+// goes off the fronting bits rather than the current fronters list,
+//   that list still points at old frontables right after a flush
+static void build_fronting_ranks(uint16_t* ranks) {
+    uint16_t num_fronting = 0;
+    for (uint16_t i = 0; i < num_ranked; i++) {
+        if (frontable_get_is_fronting(get_sent_frontable(i))) {
+            num_fronting++;
+        }
+    }
+
+    // fronting first with the newest fronts on top, then everyone
+    //   else in sent order. only fronters need the inner loop
+    uint16_t next_rank = num_fronting;
+    for (uint16_t i = 0; i < num_ranked; i++) {
+        Frontable* frontable = get_sent_frontable(i);
+        if (frontable->id >= num_ranked) continue;
+
+        if (!frontable_get_is_fronting(frontable)) {
+            ranks[frontable->id] = next_rank++;
+            continue;
+        }
+
+        uint16_t rank = 0;
+        for (uint16_t j = 0; j < num_ranked; j++) {
+            Frontable* other = get_sent_frontable(j);
+            if (!frontable_get_is_fronting(other)) continue;
+
+            if (
+                other->time_started_fronting > frontable->time_started_fronting ||
+                (other->time_started_fronting == frontable->time_started_fronting && j < i)
+            ) {
+                rank++;
+            }
+        }
+
+        ranks[frontable->id] = rank;
+    }
+}
+
+// counting sort over color buckets, stable so names stay sorted within a color
+static void build_color_ranks(uint16_t* ranks) {
+    uint16_t bucket_starts[COLOR_SORT_BUCKETS] = {0};
+
+    for (uint16_t i = 0; i < num_ranked; i++) {
+        uint8_t key = get_color_key(frontable_get_color(get_sent_frontable(i)));
+        if (key + 1 < COLOR_SORT_BUCKETS) {
+            bucket_starts[key + 1]++;
+        }
+    }
+
+    for (uint8_t i = 1; i < COLOR_SORT_BUCKETS; i++) {
+        bucket_starts[i] += bucket_starts[i - 1];
+    }
+
+    for (uint16_t i = 0; i < num_ranked; i++) {
+        Frontable* frontable = get_sent_frontable(i);
+        if (frontable->id < num_ranked) {
+            ranks[frontable->id] = bucket_starts[get_color_key(frontable_get_color(frontable))]++;
+        }
+    }
+}
+
+static void clear_sort_ranks() {
+    for (uint8_t i = 0; i < SORT_ORDER_COUNT; i++) {
+        if (sort_ranks[i] != NULL) {
+            heap_stats_free(sort_ranks[i]);
+            sort_ranks[i] = NULL;
+        }
+    }
+
+    num_ranked = 0;
+}
+
+// lists only change on flush or load, so every order is computed once here
+static void build_sort_ranks() {
+    clear_sort_ranks();
+
+    num_ranked = custom_fronts.num_stored + members.num_stored;
+    if (num_ranked == 0) return;
+
+    for (uint8_t i = 0; i < SORT_ORDER_COUNT; i++) {
+        if (i == SORT_ORDER_NAME) continue;
+
+        sort_ranks[i] = heap_stats_malloc(HEAP_TAG_CACHE, sizeof(uint16_t) * num_ranked);
+        if (sort_ranks[i] == NULL) {
+            APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Not enough memory for sort order %d, falling back to name order!", i);
+        }
+    }
+
+    if (sort_ranks[SORT_ORDER_FRONTING] != NULL) {
+        build_fronting_ranks(sort_ranks[SORT_ORDER_FRONTING]);
+    }
+
+    if (sort_ranks[SORT_ORDER_COLOR] != NULL) {
+        build_color_ranks(sort_ranks[SORT_ORDER_COLOR]);
+    }
+}
+
+void cache_sort_list(FrontableList* list) {
+    uint8_t order = settings_get()->sort_order;
+    const uint16_t* ranks = order < SORT_ORDER_COUNT ? sort_ranks[order] : NULL;
+
+    frontable_list_apply_ranks(list, ranks, num_ranked);
+
+    // jump indices follow whatever order is shown
+    frontable_list_build_letter_index(list);
+}
+
+void cache_apply_sort_order() {
+    cache_sort_list(&members);
+    cache_sort_list(&custom_fronts);
+
+    for (uint16_t i = 0; i < groups.num_stored; i++) {
+        cache_sort_list(groups.groups[i]->frontables);
+    }
+}
+
 void cache_queue_flush_frontables() {
+    trace_record(TRACE_EVENT_FLUSH_FRONTABLES_START, frontable_queue_count);
+
     cache_clear_frontables();
 
+    // group lists are only read by group menus, skip them if those are shed
+    bool fill_groups = !memory_governor_is_shedding(MEMORY_LEVEL_NO_GROUPS);
+
     for (uint16_t i = 0; i < frontable_queue_count; i++) {
-        // if current frontable is a member, add it to its groups
         Frontable* member = frontable_queue[i];
-        if (!frontable_get_is_custom(member)) {
+        if (!cache_add_frontable(member)) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Out of memory, dropping frontable '%s'!", member->name);
+            frontable_destroy(member);
+            continue;
+        }
+
+        // if current frontable is a member, add it to its groups
+        if (fill_groups && !frontable_get_is_custom(member)) {
             for (uint16_t j = 0; j < groups.num_stored; j++) {
                 // check bit field, if flag at that given index is 1
                 //   add to the group at that index
@@ -221,14 +442,32 @@ void cache_queue_flush_frontables() {
                 }
             }
         }
-
-        cache_add_frontable(frontable_queue[i]);
     }
 
     frontable_queue_count = 0;
+
+    build_sort_ranks();
+    cache_apply_sort_order();
+
+    trace_record(TRACE_EVENT_FLUSH_FRONTABLES_END, 0);
+}
+
+void cache_shed_pronouns() {
+    for (uint16_t i = 0; i < members.num_stored; i++) {
+        frontable_set_pronouns(members.frontables[i], NULL);
+    }
+
+    for (uint16_t i = 0; i < frontable_queue_count; i++) {
+        frontable_set_pronouns(frontable_queue[i], NULL);
+    }
+
+    // rows laid out with pronouns would keep their subtitle space
+    frontable_menu_invalidate_layouts();
 }
 
 void cache_queue_flush_groups() {
+    trace_record(TRACE_EVENT_FLUSH_GROUPS_START, group_queue_count);
+
     cache_clear_groups();
 
     for (uint16_t i = 0; i < group_queue_count; i++) {
@@ -236,27 +475,100 @@ void cache_queue_flush_groups() {
     }
 
     group_queue_count = 0;
+
+    trace_record(TRACE_EVENT_FLUSH_GROUPS_END, 0);
 }
 
 void cache_queue_flush_current_fronters() {
+    trace_record(TRACE_EVENT_FLUSH_CURRENT_FRONTS_START, current_fronter_queue_count);
+
     cache_clear_current_fronters();
 
     for (uint16_t i = 0; i < current_fronter_queue_count; i++) {
         CurrentFrontData data = current_fronter_queue[i];
-        cache_add_current_fronter(data.hash, data.start_time);
+        cache_add_current_fronter(data.id, data.start_time);
     }
 
     current_fronter_queue_count = 0;
+
+    // fronting order is the only one that depends on who's fronting
+    if (sort_ranks[SORT_ORDER_FRONTING] != NULL) {
+        build_fronting_ranks(sort_ranks[SORT_ORDER_FRONTING]);
+
+        if (settings_get()->sort_order == SORT_ORDER_FRONTING) {
+            cache_apply_sort_order();
+        }
+    }
+
+    trace_record(TRACE_EVENT_FLUSH_CURRENT_FRONTS_END, 0);
+}
+
+// ~~~ PERSISTENT STORAGE ~~~
+
+static int8_t active_slot = -1;
+static uint32_t active_generation = 0;
+
+// FNV-1a, plenty to catch torn or partially written chunks
+static uint32_t checksum(const uint8_t* data, uint16_t length) {
+    uint32_t hash = 2166136261u;
+    for (uint16_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool stream_write(CacheStream* stream, const void* src, uint16_t size) {
+    if (stream->length + size > stream->capacity) {
+        return false;
+    }
+
+    memcpy(&stream->data[stream->length], src, size);
+    stream->length += size;
+    return true;
+}
+
+static bool stream_read(CacheStream* stream, void* dest, uint16_t size) {
+    if (stream->cursor + size > stream->length) {
+        return false;
+    }
+
+    memcpy(dest, &stream->data[stream->cursor], size);
+    stream->cursor += size;
+    return true;
+}
+
+// strings are stored as a length byte followed by the characters
+static uint16_t string_record_length(const char* str, uint16_t max_size) {
+    // same cut as string_safe_copy so it loads back as whole characters
+    return string_fit_length(str, max_size - 1);
+}
+
+static bool stream_write_string(CacheStream* stream, const char* str, uint16_t max_size) {
+    uint8_t len = string_record_length(str, max_size);
+    return stream_write(stream, &len, sizeof(uint8_t)) && stream_write(stream, str, len);
 }
 
-static void store_pronoun_map(char* pronoun_map, size_t pronoun_map_size) {
-    uint16_t pronoun_index = 0;
+static bool stream_read_string(CacheStream* stream, char* dest, uint16_t dest_size) {
+    uint8_t len = 0;
+    if (!stream_read(stream, &len, sizeof(uint8_t)) || len >= dest_size) {
+        return false;
+    }
+
+    dest[len] = '\0';
+    return stream_read(stream, dest, len);
+}
+
+static uint8_t build_pronoun_map(char* pronoun_map) {
+    uint8_t num_pronouns = 0;
 
     for (uint16_t i = 0; i < members.num_stored; i++) {
         Frontable* member = members.frontables[i];
+        if (member->pronouns[0] == '\0') continue;
 
         bool pronouns_exist = false;
-        for (uint16_t j = 0; j < MAX_CACHED_PRONOUNS; j++) {
+        for (uint16_t j = 0; j < num_pronouns; j++) {
             char* pronouns = pronoun_map + (j * (COMPRESSED_PRONOUNS_LENGTH));
             if (string_start_same(member->pronouns, pronouns)) {
                 pronouns_exist = true;
@@ -265,310 +577,587 @@ static void store_pronoun_map(char* pronoun_map, size_t pronoun_map_size) {
         }
 
         // add to array if they haven't been cached yet
-        if (!pronouns_exist && pronoun_index < MAX_CACHED_PRONOUNS) {
+        if (!pronouns_exist && num_pronouns < MAX_CACHED_PRONOUNS) {
             string_safe_copy(
-                pronoun_map + (pronoun_index * COMPRESSED_PRONOUNS_LENGTH),
+                pronoun_map + (num_pronouns * COMPRESSED_PRONOUNS_LENGTH),
                 member->pronouns,
                 COMPRESSED_PRONOUNS_LENGTH
             );
-            pronoun_index++;
+            num_pronouns++;
         }
     }
 
-    persist_write_data(PRONOUNS_KEY, pronoun_map, pronoun_map_size);
+    return num_pronouns;
 }
 
-static void store_frontables(char* pronoun_map) {
-    CompressedFrontable* frontables_to_store = (CompressedFrontable*)malloc(
-        sizeof(CompressedFrontable) * MAX_CACHED_FRONTABLES
-    );
-    uint16_t frontable_index = 0;
-
-    // convert custom fronts into compressed frontables
-    for (uint16_t i = 0; i < custom_fronts.num_stored; i++) {
-        if (frontable_index >= MAX_CACHED_FRONTABLES) break;
-
-        Frontable* custom_front = custom_fronts.frontables[i];
-
-        frontables_to_store[frontable_index] = (CompressedFrontable) {
-            .hash = custom_front->hash,
-            .packed_data = custom_front->packed_data,
-            .pronoun_index = 0,
-            .group_bit_field = 0
-        };
-        string_safe_copy(
-            frontables_to_store[frontable_index].name,
-            custom_front->name,
-            COMPRESSED_NAME_LENGTH
-        );
-
-        frontable_index++;
-    }
+// returns pronoun index + 1, or 0 if pronouns aren't in the map
+static uint8_t find_pronoun_index(const char* pronouns, const char* pronoun_map, uint8_t num_pronouns) {
+    if (pronouns[0] == '\0') return 0;
 
-    // convert members into compressed frontables
-    for (uint16_t i = 0; i < members.num_stored; i++) {
-        if (frontable_index >= MAX_CACHED_FRONTABLES) break;
-
-        Frontable* member = members.frontables[i];
-
-        // find index of pronouns, pronoun_index counts the
-        //   number of stored pronouns at this point
-        uint8_t pronoun_index = 0;
-        for (uint16_t j = 0; j < MAX_CACHED_PRONOUNS; j++) {
-            if (string_start_same(member->pronouns, pronoun_map + (j * (COMPRESSED_PRONOUNS_LENGTH)))) {
-                pronoun_index = j + 1;
-                break;
-            }
+    for (uint8_t i = 0; i < num_pronouns; i++) {
+        if (string_start_same(pronouns, pronoun_map + (i * (COMPRESSED_PRONOUNS_LENGTH)))) {
+            return i + 1;
         }
-
-        frontables_to_store[frontable_index] = (CompressedFrontable) {
-            .hash = member->hash,
-            .packed_data = member->packed_data,
-            .pronoun_index = pronoun_index,
-            .group_bit_field = member->group_bit_field
-        };
-        string_safe_copy(
-            frontables_to_store[frontable_index].name,
-            member->name,
-            COMPRESSED_NAME_LENGTH
-        );
-
-        frontable_index++;
     }
 
-    // store chunks
-    int32_t remaining_frontables = frontable_index;
-    persist_write_int(FRONTABLES_NUM_KEY, remaining_frontables);
-    uint16_t index_offset = 0;
-    for (uint32_t key = FRONTABLES_KEY_MIN; key <= FRONTABLES_KEY_MAX; key++) {
-        if (remaining_frontables <= 0) break;
-
-        uint16_t num_to_store = PERSIST_DATA_MAX_LENGTH / sizeof(CompressedFrontable);
-        if (num_to_store > remaining_frontables) num_to_store = remaining_frontables;
-        uint16_t size = num_to_store * sizeof(CompressedFrontable);
-
-        persist_write_data(key, &frontables_to_store[index_offset], size);
+    return 0;
+}
 
-        index_offset += num_to_store;
-        remaining_frontables -= num_to_store;
+static bool serialize_frontable(CacheStream* stream, Frontable* frontable, uint8_t pronoun_index) {
+    // make sure the whole record fits so a frontable is never half-written
+    uint16_t name_length = string_record_length(frontable->name, COMPRESSED_NAME_LENGTH);
+    uint16_t record_size = sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint8_t) * 3 + name_length;
+    if (stream->length + record_size > stream->capacity) {
+        return false;
     }
 
-    free(frontables_to_store);
+    uint32_t group_bit_field = frontable_get_is_custom(frontable) ? 0 : frontable->group_bit_field;
+
+    stream_write(stream, &frontable->id, sizeof(uint16_t));
+    stream_write(stream, &group_bit_field, sizeof(uint32_t));
+    stream_write(stream, &pronoun_index, sizeof(uint8_t));
+    stream_write(stream, &frontable->packed_data, sizeof(uint8_t));
+    stream_write_string(stream, frontable->name, COMPRESSED_NAME_LENGTH);
+    return true;
 }
 
-static void store_groups() {
-    CompressedGroup* groups_to_store = malloc(
-        sizeof(CompressedGroup) * MAX_CACHED_GROUPS
-    );
+static void serialize_cache(CacheStream* stream, CacheSlotHeader* header) {
+    size_t map_size = sizeof(char) * MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH);
+    char* pronoun_map = (char*)heap_stats_malloc(HEAP_TAG_CACHE, map_size);
+    memset(pronoun_map, '\0', map_size);
 
-    // convert cached groups into compressed groups
-    uint16_t group_index = 0;
-    for (uint16_t i = 0; i < groups.num_stored; i++) {
-        if (group_index >= MAX_CACHED_GROUPS) break;
+    // pronouns first, frontables refer to them by index
+    uint8_t num_pronouns = build_pronoun_map(pronoun_map);
+    for (uint8_t i = 0; i < num_pronouns; i++) {
+        if (!stream_write_string(stream, pronoun_map + (i * COMPRESSED_PRONOUNS_LENGTH), COMPRESSED_PRONOUNS_LENGTH)) {
+            num_pronouns = i;
+            break;
+        }
+    }
+    header->num_pronouns = num_pronouns;
 
+    // groups next, frontable bit fields refer to them by index
+    for (uint16_t i = 0; i < groups.num_stored && i < MAX_CACHED_GROUPS; i++) {
         Group* group = groups.groups[i];
 
         int16_t parent_index = -1;
         for (uint16_t j = 0; j < groups.num_stored; j++) {
-            Group* parent = groups.groups[j];
-            if (i != j && group->parent == parent) {
+            if (i != j && group->parent == groups.groups[j]) {
                 parent_index = j;
             }
         }
 
-        groups_to_store[group_index] = (CompressedGroup) {
-            .color = group->color.argb,
-            .parent_index = (uint8_t)(parent_index + 1)
-        };
-        string_safe_copy(
-            groups_to_store[group_index].name,
-            group->name,
-            COMPRESSED_NAME_LENGTH
-        );
+        uint16_t name_length = string_record_length(group->name, COMPRESSED_NAME_LENGTH);
+        if (stream->length + sizeof(uint8_t) * 3 + name_length > stream->capacity) {
+            break;
+        }
 
-        group_index++;
+        uint8_t color = group->color.argb;
+        uint8_t parent = (uint8_t)(parent_index + 1);
+        stream_write(stream, &color, sizeof(uint8_t));
+        stream_write(stream, &parent, sizeof(uint8_t));
+        stream_write_string(stream, group->name, COMPRESSED_NAME_LENGTH);
+        header->num_groups++;
     }
 
-    // store chunks
-    int32_t remaining_groups = group_index;
-    persist_write_int(GROUPS_NUM_KEY, remaining_groups);
-    uint16_t index_offset = 0;
-    for (uint32_t key = GROUPS_KEY_MIN; key <= GROUPS_KEY_MAX; key++) {
-        if (remaining_groups <= 0) break;
+    // custom fronts before members, same as the order they're sent in
+    bool full = false;
+    for (uint16_t i = 0; i < custom_fronts.num_stored && !full; i++) {
+        full = !serialize_frontable(stream, custom_fronts.frontables[i], 0);
+        if (!full) header->num_frontables++;
+    }
 
-        uint16_t num_to_store = PERSIST_DATA_MAX_LENGTH / sizeof(CompressedGroup);
-        if (num_to_store > remaining_groups) num_to_store = remaining_groups;
-        uint16_t size = num_to_store * sizeof(CompressedFrontable);
+    for (uint16_t i = 0; i < members.num_stored && !full; i++) {
+        Frontable* member = members.frontables[i];
+        uint8_t pronoun_index = find_pronoun_index(member->pronouns, pronoun_map, num_pronouns);
 
-        persist_write_data(key, &groups_to_store[index_offset], size);
+        full = !serialize_frontable(stream, member, pronoun_index);
+        if (!full) header->num_frontables++;
+    }
 
-        index_offset += num_to_store;
-        remaining_groups -= num_to_store;
+    if (full) {
+        APP_LOG(
+            APP_LOG_LEVEL_WARNING,
+            "WARNING: Persistent cache slot is full, only %d frontables will be stored!",
+            (int)header->num_frontables
+        );
     }
 
-    free(groups_to_store);
+    heap_stats_free(pronoun_map);
 }
 
-static void load_frontables(char* pronoun_map) {
-    CompressedFrontable* cached_frontables = (CompressedFrontable*)malloc(
-        sizeof(CompressedFrontable) * MAX_CACHED_FRONTABLES
-    );
-    int32_t num_frontables = persist_read_int(FRONTABLES_NUM_KEY);
+static bool deserialize_cache(CacheStream* stream, const CacheSlotHeader* header) {
+    size_t map_size = sizeof(char) * MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH);
+    char* pronoun_map = (char*)heap_stats_malloc(HEAP_TAG_CACHE, map_size);
+    memset(pronoun_map, '\0', map_size);
 
-    // retrieve chunks from storage
-    int32_t remaining_frontables = num_frontables;
-    uint16_t index_offset = 0;
-    for (uint32_t key = FRONTABLES_KEY_MIN; key <= FRONTABLES_KEY_MAX; key++) {
-        if (remaining_frontables <= 0) break;
+    bool valid = header->num_pronouns <= MAX_CACHED_PRONOUNS &&
+                 header->num_groups <= MAX_CACHED_GROUPS;
+
+    for (uint8_t i = 0; valid && i < header->num_pronouns; i++) {
+        valid = stream_read_string(stream, pronoun_map + (i * COMPRESSED_PRONOUNS_LENGTH), COMPRESSED_PRONOUNS_LENGTH);
+    }
 
-        uint16_t num_to_load = PERSIST_DATA_MAX_LENGTH / sizeof(CompressedFrontable);
-        if (num_to_load > remaining_frontables) num_to_load = remaining_frontables;
-        uint16_t size = num_to_load * sizeof(CompressedFrontable);
+    // load groups before frontables, frontables access groups
+    uint8_t parent_indices[MAX_CACHED_GROUPS];
+    for (uint8_t i = 0; valid && i < header->num_groups; i++) {
+        uint8_t color = 0;
+        char name[COMPRESSED_NAME_LENGTH];
 
-        persist_read_data(key, &cached_frontables[index_offset], size);
+        valid = stream_read(stream, &color, sizeof(uint8_t)) &&
+                stream_read(stream, &parent_indices[i], sizeof(uint8_t)) &&
+                stream_read_string(stream, name, sizeof(name));
 
-        index_offset += num_to_load;
-        remaining_frontables -= num_to_load;
+        if (valid) {
+            cache_add_group(group_create(name, (GColor) {.argb = color}, NULL));
+        }
     }
 
-    // load frontables from stored compressed data
-    for (int32_t i = 0; i < num_frontables; i++) {
-        CompressedFrontable* cached = &cached_frontables[i];
+    // assign parent pointers
+    for (uint8_t i = 0; valid && i < groups.num_stored; i++) {
+        uint8_t parent_index = parent_indices[i];
+        if (parent_index > 0 && parent_index <= groups.num_stored) {
+            groups.groups[i]->parent = groups.groups[parent_index - 1];
+        }
+    }
 
-        Frontable* f = frontable_create(
-            cached->hash,
-            cached->name,
-            NULL,
-            false,
-            GColorBlack
-        );
+    for (uint16_t i = 0; valid && i < header->num_frontables; i++) {
+        uint16_t id = 0;
+        uint32_t group_bit_field = 0;
+        uint8_t pronoun_index = 0;
+        uint8_t packed_data = 0;
+        char name[COMPRESSED_NAME_LENGTH];
+
+        valid = stream_read(stream, &id, sizeof(uint16_t)) &&
+                stream_read(stream, &group_bit_field, sizeof(uint32_t)) &&
+                stream_read(stream, &pronoun_index, sizeof(uint8_t)) &&
+                stream_read(stream, &packed_data, sizeof(uint8_t)) &&
+                stream_read_string(stream, name, sizeof(name));
 
-        f->packed_data = cached->packed_data;
-        f->group_bit_field = cached->group_bit_field;
+        if (!valid) break;
+
+        Frontable* f = frontable_create(id, name, NULL, false, GColorBlack);
+        if (f == NULL) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Out of memory, dropping the rest of the cached frontables!");
+            break;
+        }
+
+        f->packed_data = packed_data;
+        f->group_bit_field = group_bit_field;
         // TODO: cache time started fronting too
         f->time_started_fronting = 0;
 
-        if (cached->pronoun_index > 0) {
-            uint16_t index = cached->pronoun_index - 1;
-            string_safe_copy(
-                f->pronouns,
-                &pronoun_map[index * (COMPRESSED_PRONOUNS_LENGTH)],
-                FRONTABLE_PRONOUNS_LENGTH
-            );
+        if (pronoun_index > 0 && pronoun_index <= header->num_pronouns) {
+            frontable_set_pronouns(f, &pronoun_map[(pronoun_index - 1) * (COMPRESSED_PRONOUNS_LENGTH)]);
+        }
+
+        if (!cache_add_frontable(f)) {
+            frontable_destroy(f);
+            continue;
         }
 
-        cache_add_frontable(f);
         if (frontable_get_is_fronting(f)) {
-            cache_add_current_fronter(f->hash, f->time_started_fronting);
+            cache_add_current_fronter(f->id, f->time_started_fronting);
         }
     }
 
+    heap_stats_free(pronoun_map);
+
+    if (!valid) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Persistent cache slot is malformed, discarding it!");
+        cache_clear_current_fronters();
+        cache_clear_frontables();
+        cache_clear_groups();
+        return false;
+    }
+
     // re-iterate to assign frontables to groups
     for (uint16_t i = 0; i < members.num_stored; i++) {
         Frontable* member = members.frontables[i];
 
         for (uint16_t j = 0; j < groups.num_stored; j++) {
-            Group* group = groups.groups[j];
-
             if (((member->group_bit_field >> j) & 1) != 0) {
-                frontable_list_add(member, group->frontables);
+                frontable_list_add(member, groups.groups[j]->frontables);
             }
         }
     }
 
-    free(cached_frontables);
+    build_sort_ranks();
+    cache_apply_sort_order();
+
+    return true;
+}
+
+static bool read_slot_header(uint8_t slot, CacheSlotHeader* header) {
+    uint32_t key = CACHE_SLOT_HEADER_KEY(slot);
+    if (!persist_exists(key) || persist_get_size(key) != sizeof(CacheSlotHeader)) {
+        return false;
+    }
+
+    persist_read_data(key, header, sizeof(CacheSlotHeader));
+    return header->length <= CACHE_SLOT_MAX_BYTES;
+}
+
+static bool read_slot_data(uint8_t slot, const CacheSlotHeader* header, CacheStream* stream) {
+    uint16_t offset = 0;
+    for (uint8_t chunk = 0; offset < header->length; chunk++) {
+        uint16_t size = header->length - offset;
+        if (size > PERSIST_DATA_MAX_LENGTH) size = PERSIST_DATA_MAX_LENGTH;
+
+        if (persist_read_data(CACHE_SLOT_CHUNK_KEY(slot, chunk), &stream->data[offset], size) != size) {
+            return false;
+        }
+
+        offset += size;
+    }
+
+    stream->length = header->length;
+    stream->cursor = 0;
+
+    return checksum(stream->data, stream->length) == header->checksum;
+}
+
+static bool write_slot(uint8_t slot, const CacheStream* stream, const CacheSlotHeader* header) {
+    // invalidate the slot first, if we die mid-write the
+    //   loader falls back to the other (still intact) slot
+    persist_delete(CACHE_SLOT_HEADER_KEY(slot));
+
+    uint8_t chunk = 0;
+    for (uint16_t offset = 0; offset < stream->length; chunk++) {
+        uint16_t size = stream->length - offset;
+        if (size > PERSIST_DATA_MAX_LENGTH) size = PERSIST_DATA_MAX_LENGTH;
+
+        int result = persist_write_data(CACHE_SLOT_CHUNK_KEY(slot, chunk), &stream->data[offset], size);
+        if (result < 0) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Failed to write cache chunk %d, status: %d", (int)chunk, result);
+            return false;
+        }
+
+        offset += size;
+    }
+
+    // drop chunks left over from a bigger previous write
+    for (; chunk < CACHE_SLOT_MAX_CHUNKS; chunk++) {
+        persist_delete(CACHE_SLOT_CHUNK_KEY(slot, chunk));
+    }
+
+    // header goes last, this is what commits the slot
+    return persist_write_data(CACHE_SLOT_HEADER_KEY(slot), header, sizeof(CacheSlotHeader)) >= 0;
+}
+
+static void delete_legacy_keys() {
+    persist_delete(LEGACY_PRONOUNS_KEY);
+    persist_delete(LEGACY_FRONTABLES_NUM_KEY);
+    persist_delete(LEGACY_GROUPS_NUM_KEY);
+    for (uint32_t key = LEGACY_FRONTABLES_KEY_MIN; key <= LEGACY_FRONTABLES_KEY_MAX; key++) {
+        persist_delete(key);
+    }
+    for (uint32_t key = LEGACY_GROUPS_KEY_MIN; key <= LEGACY_GROUPS_KEY_MAX; key++) {
+        persist_delete(key);
+    }
 }
 
-static void load_groups() {
-    CompressedGroup* cached_groups = malloc(
-        sizeof(CompressedGroup) * MAX_CACHED_GROUPS
-    );
-    int32_t num_groups = persist_read_int(GROUPS_NUM_KEY);
+// reads the legacy in-place keys straight into a format 1 stream
+static bool migrate_legacy(CacheStream* stream, CacheSlotHeader* header) {
+    if (
+        !persist_exists(LEGACY_PRONOUNS_KEY) ||
+        !persist_exists(LEGACY_FRONTABLES_NUM_KEY) ||
+        !persist_exists(LEGACY_GROUPS_NUM_KEY)
+    ) {
+        return false;
+    }
+
+    size_t map_size = sizeof(char) * MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH);
+    size_t groups_size = sizeof(LegacyCompressedGroup) * MAX_CACHED_GROUPS;
+    size_t frontables_size = sizeof(LegacyCompressedFrontable) * LEGACY_MAX_CACHED_FRONTABLES;
+
+    char* pronoun_map = (char*)heap_stats_malloc(HEAP_TAG_CACHE, map_size);
+    LegacyCompressedGroup* cached_groups = (LegacyCompressedGroup*)heap_stats_malloc(HEAP_TAG_CACHE, groups_size);
+    LegacyCompressedFrontable* cached_frontables = (LegacyCompressedFrontable*)heap_stats_malloc(HEAP_TAG_CACHE, frontables_size);
+    memset(pronoun_map, '\0', map_size);
+    memset(cached_groups, 0, groups_size);
+    memset(cached_frontables, 0, frontables_size);
+
+    persist_read_data(LEGACY_PRONOUNS_KEY, pronoun_map, map_size);
 
-    // retrieve chunks from storage
-    int32_t remaining_groups = num_groups;
+    int32_t num_groups = persist_read_int(LEGACY_GROUPS_NUM_KEY);
+    if (num_groups > MAX_CACHED_GROUPS) num_groups = MAX_CACHED_GROUPS;
+    int32_t num_frontables = persist_read_int(LEGACY_FRONTABLES_NUM_KEY);
+    if (num_frontables > LEGACY_MAX_CACHED_FRONTABLES) num_frontables = LEGACY_MAX_CACHED_FRONTABLES;
+
+    bool valid = true;
+
+    // retrieve group chunks from storage
+    int32_t remaining = num_groups;
     uint16_t index_offset = 0;
-    for (uint32_t key = GROUPS_KEY_MIN; key <= GROUPS_KEY_MAX; key++) {
-        if (remaining_groups <= 0) break;
+    for (uint32_t key = LEGACY_GROUPS_KEY_MIN; key <= LEGACY_GROUPS_KEY_MAX && valid; key++) {
+        if (remaining <= 0) break;
 
-        uint16_t num_to_load = PERSIST_DATA_MAX_LENGTH / sizeof(CompressedGroup);
-        if (num_to_load > remaining_groups) num_to_load = remaining_groups;
-        uint16_t size = num_to_load * sizeof(CompressedGroup);
+        uint16_t num_to_load = PERSIST_DATA_MAX_LENGTH / sizeof(LegacyCompressedGroup);
+        if (num_to_load > remaining) num_to_load = remaining;
+        uint16_t size = num_to_load * sizeof(LegacyCompressedGroup);
 
-        persist_read_data(key, &cached_groups[index_offset], size);
+        valid = persist_read_data(key, &cached_groups[index_offset], size) == size;
 
         index_offset += num_to_load;
-        remaining_groups -= num_to_load;
+        remaining -= num_to_load;
     }
 
-    // load groups from compressed data
-    for (int32_t i = 0; i < num_groups; i++) {
-        CompressedGroup* cached = &cached_groups[i];
+    // retrieve frontable chunks from storage
+    remaining = num_frontables;
+    index_offset = 0;
+    for (uint32_t key = LEGACY_FRONTABLES_KEY_MIN; key <= LEGACY_FRONTABLES_KEY_MAX && valid; key++) {
+        if (remaining <= 0) break;
 
-        Group* g = group_create(
-            cached->name,
-            (GColor) {.argb = cached->color},
-            NULL
-        );
+        uint16_t num_to_load = PERSIST_DATA_MAX_LENGTH / sizeof(LegacyCompressedFrontable);
+        if (num_to_load > remaining) num_to_load = remaining;
+        uint16_t size = num_to_load * sizeof(LegacyCompressedFrontable);
 
-        cache_add_group(g);
+        valid = persist_read_data(key, &cached_frontables[index_offset], size) == size;
+
+        index_offset += num_to_load;
+        remaining -= num_to_load;
     }
 
-    // assign parent pointers
-    for (int32_t i = 0; i < num_groups; i++) {
-        CompressedGroup* cached = &cached_groups[i];
-        Group* group = groups.groups[i];
+    if (valid) {
+        // pronoun indices were map position + 1, entries are contiguous
+        for (uint8_t i = 0; i < MAX_CACHED_PRONOUNS; i++) {
+            char* pronouns = pronoun_map + (i * COMPRESSED_PRONOUNS_LENGTH);
+            pronouns[COMPRESSED_PRONOUNS_LENGTH - 1] = '\0';
+            if (pronouns[0] == '\0' || !stream_write_string(stream, pronouns, COMPRESSED_PRONOUNS_LENGTH)) break;
+            header->num_pronouns++;
+        }
+
+        for (int32_t i = 0; i < num_groups; i++) {
+            LegacyCompressedGroup* cached = &cached_groups[i];
+            cached->name[COMPRESSED_NAME_LENGTH - 1] = '\0';
 
-        if (cached->parent_index > 0) {
-            group->parent = groups.groups[cached->parent_index - 1];
+            if (
+                !stream_write(stream, &cached->color, sizeof(uint8_t)) ||
+                !stream_write(stream, &cached->parent_index, sizeof(uint8_t)) ||
+                !stream_write_string(stream, cached->name, COMPRESSED_NAME_LENGTH)
+            ) {
+                valid = false;
+                break;
+            }
+            header->num_groups++;
+        }
+    }
+
+    for (int32_t i = 0; i < num_frontables && valid; i++) {
+        LegacyCompressedFrontable* cached = &cached_frontables[i];
+        cached->name[COMPRESSED_NAME_LENGTH - 1] = '\0';
+
+        uint8_t pronoun_index = cached->pronoun_index;
+        if (pronoun_index > header->num_pronouns) pronoun_index = 0;
+
+        // legacy stored more frontables than a slot can hold, keep what fits
+        uint16_t record_size = sizeof(uint32_t) * 2 + sizeof(uint8_t) * 3 +
+                               string_record_length(cached->name, COMPRESSED_NAME_LENGTH);
+        if (stream->length + record_size > stream->capacity) break;
+
+        stream_write(stream, &cached->hash, sizeof(uint32_t));
+        stream_write(stream, &cached->group_bit_field, sizeof(uint32_t));
+        stream_write(stream, &pronoun_index, sizeof(uint8_t));
+        stream_write(stream, &cached->packed_data, sizeof(uint8_t));
+        stream_write_string(stream, cached->name, COMPRESSED_NAME_LENGTH);
+        header->num_frontables++;
+    }
+
+    heap_stats_free(cached_frontables);
+    heap_stats_free(cached_groups);
+    heap_stats_free(pronoun_map);
+
+    header->length = stream->length;
+    stream->cursor = 0;
+
+    return valid;
+}
+
+// 1 -> 2: 32-bit hashes became dense ids. records were stored in the
+//   order the phone sent them, so a record's position is its id
+static bool migrate_hashes_to_ids(CacheStream* stream, CacheSlotHeader* header) {
+    char skipped[COMPRESSED_NAME_LENGTH];
+    uint8_t fields[sizeof(uint32_t) + sizeof(uint8_t) * 2];
+
+    // pronouns and groups didn't change, skip past them
+    bool valid = true;
+    for (uint8_t i = 0; valid && i < header->num_pronouns; i++) {
+        valid = stream_read_string(stream, skipped, sizeof(skipped));
+    }
+
+    for (uint8_t i = 0; valid && i < header->num_groups; i++) {
+        valid = stream_read(stream, fields, sizeof(uint8_t) * 2) &&
+                stream_read_string(stream, skipped, sizeof(skipped));
+    }
+
+    // records only shrink, so they're shifted down in place
+    uint16_t write_offset = stream->cursor;
+    for (uint16_t id = 0; valid && id < header->num_frontables; id++) {
+        uint32_t hash = 0;
+        valid = stream_read(stream, &hash, sizeof(uint32_t));
+        uint16_t tail_offset = stream->cursor;
+
+        valid = valid &&
+                stream_read(stream, fields, sizeof(fields)) &&
+                stream_read_string(stream, skipped, sizeof(skipped));
+        if (!valid) break;
+
+        uint16_t tail_size = stream->cursor - tail_offset;
+        memcpy(&stream->data[write_offset], &id, sizeof(uint16_t));
+        memmove(&stream->data[write_offset + sizeof(uint16_t)], &stream->data[tail_offset], tail_size);
+        write_offset += sizeof(uint16_t) + tail_size;
+    }
+
+    stream->length = write_offset;
+    stream->cursor = 0;
+    header->length = write_offset;
+
+    return valid;
+}
+
+// forward migrations, CACHE_MIGRATIONS[n] rewrites a stream from format
+//   version n into version n + 1. a NULL entry means the formats are
+//   truly incompatible and the cache has to be fetched from scratch
+typedef bool (*CacheMigration)(CacheStream* stream, CacheSlotHeader* header);
+
+static const CacheMigration CACHE_MIGRATIONS[CACHE_FORMAT_VERSION] = {
+    // 0 -> 1: fixed size in-place records into a packed A/B slot stream
+    migrate_legacy,
+    // 1 -> 2: frontable hashes into dense ids
+    migrate_hashes_to_ids,
+};
+
+static bool migrate(CacheStream* stream, CacheSlotHeader* header) {
+    if (header->version > CACHE_FORMAT_VERSION) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Cache format %d is newer than this app, ignoring it!", (int)header->version);
+        return false;
+    }
+
+    while (header->version < CACHE_FORMAT_VERSION) {
+        CacheMigration migration = CACHE_MIGRATIONS[header->version];
+        if (migration == NULL || !migration(stream, header)) {
+            APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Cache format %d can't be migrated, it will be re-fetched!", (int)header->version);
+            return false;
         }
+
+        APP_LOG(APP_LOG_LEVEL_INFO, "Migrated cache format %d -> %d!", (int)header->version, (int)header->version + 1);
+        header->version++;
     }
 
-    free(cached_groups);
+    return true;
 }
 
 void cache_persist_store() {
     APP_LOG(APP_LOG_LEVEL_INFO, "Attempting to store frontable cache into persistent storage...");
+    trace_record(TRACE_EVENT_PERSIST_STORE_START, 0);
 
-    size_t map_size = sizeof(char) * MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH);
-    char* pronoun_map = (char*)malloc(map_size);
-    memset(pronoun_map, '\0', map_size);
+    CacheStream stream = {
+        .data = heap_stats_malloc(HEAP_TAG_CACHE, CACHE_SLOT_MAX_BYTES),
+        .capacity = CACHE_SLOT_MAX_BYTES,
+        .length = 0,
+        .cursor = 0
+    };
+    CacheSlotHeader header = {
+        .generation = active_generation + 1,
+        .version = CACHE_FORMAT_VERSION
+    };
+
+    serialize_cache(&stream, &header);
+    header.length = stream.length;
+    header.checksum = checksum(stream.data, stream.length);
 
-    store_pronoun_map(pronoun_map, map_size);
-    store_frontables(pronoun_map);
-    store_groups();
+    // the legacy layout takes up nearly all of storage on its own,
+    //   it has to go before a slot can be written next to it
+    if (persist_exists(LEGACY_FRONTABLES_NUM_KEY)) {
+        delete_legacy_keys();
+    }
+
+    // always write into the slot that isn't currently live
+    uint8_t slot = (active_slot == 0) ? 1 : 0;
+    if (write_slot(slot, &stream, &header)) {
+        active_slot = slot;
+        active_generation = header.generation;
+
+        APP_LOG(
+            APP_LOG_LEVEL_INFO,
+            "Frontable cache stored into slot %d (generation %lu, %d bytes)!",
+            (int)slot,
+            header.generation,
+            (int)header.length
+        );
+    } else {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Failed to store frontable cache, previous slot is kept!");
+    }
 
-    free(pronoun_map);
+    heap_stats_free(stream.data);
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Frontable cache stored into persistent storage!");
+    trace_record(TRACE_EVENT_PERSIST_STORE_END, header.length);
 }
 
 bool cache_persist_load() {
     APP_LOG(APP_LOG_LEVEL_INFO, "Attempting to load frontable cache from persistent storage...");
+    trace_record(TRACE_EVENT_PERSIST_LOAD_START, 0);
 
-    if (
-        !persist_exists(PRONOUNS_KEY) ||
-        !persist_exists(FRONTABLES_NUM_KEY) ||
-        !persist_exists(GROUPS_NUM_KEY)
-    ) {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Cannot load persistent data if it was never saved in the first place!");
-        return false;
+    CacheSlotHeader headers[CACHE_SLOT_COUNT];
+    bool has_header[CACHE_SLOT_COUNT];
+    for (uint8_t slot = 0; slot < CACHE_SLOT_COUNT; slot++) {
+        has_header[slot] = read_slot_header(slot, &headers[slot]);
     }
 
     cache_clear_current_fronters();
     cache_clear_frontables();
     cache_clear_groups();
 
-    // load pronoun map
-    size_t size = sizeof(char) * MAX_CACHED_PRONOUNS * (COMPRESSED_PRONOUNS_LENGTH);
-    char* pronoun_map = (char*)malloc(size);
-    persist_read_data(PRONOUNS_KEY, pronoun_map, size);
+    CacheStream stream = {
+        .data = heap_stats_malloc(HEAP_TAG_CACHE, CACHE_SLOT_MAX_BYTES),
+        .capacity = CACHE_SLOT_MAX_BYTES,
+        .length = 0,
+        .cursor = 0
+    };
 
-    // load groups before frontables, frontables access groups
-    load_groups();
-    load_frontables(pronoun_map);
+    // try the newest slot first, fall back to the older one if
+    //   the newest was torn or fails its checksum
+    bool loaded = false;
+    for (uint8_t attempt = 0; attempt < CACHE_SLOT_COUNT && !loaded; attempt++) {
+        int8_t newest = -1;
+        for (uint8_t slot = 0; slot < CACHE_SLOT_COUNT; slot++) {
+            if (has_header[slot] && (newest < 0 || headers[slot].generation > headers[newest].generation)) {
+                newest = slot;
+            }
+        }
+
+        if (newest < 0) break;
+        has_header[newest] = false;
+
+        if (!read_slot_data(newest, &headers[newest], &stream)) {
+            APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Cache slot %d failed validation, skipping it!", (int)newest);
+            continue;
+        }
+
+        if (migrate(&stream, &headers[newest]) && deserialize_cache(&stream, &headers[newest])) {
+            active_slot = newest;
+            active_generation = headers[newest].generation;
+            loaded = true;
+        }
+    }
+
+    // installs from before slots existed only have the legacy keys
+    if (!loaded && persist_exists(LEGACY_FRONTABLES_NUM_KEY)) {
+        CacheSlotHeader header = {.version = 0};
+        stream.length = 0;
+
+        loaded = migrate(&stream, &header) && deserialize_cache(&stream, &header);
+    }
+
+    heap_stats_free(stream.data);
 
-    free(pronoun_map);
+    trace_record(TRACE_EVENT_PERSIST_LOAD_END, loaded);
+
+    if (!loaded) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "Cannot load persistent data if it was never saved in the first place!");
+        return false;
+    }
 
     APP_LOG(APP_LOG_LEVEL_INFO, "Frontable cache loaded from persistent storage!");
 
@@ -576,48 +1165,71 @@ bool cache_persist_load() {
 }
 
 void cache_persist_delete() {
-    persist_delete(PRONOUNS_KEY);
-    persist_delete(FRONTABLES_NUM_KEY);
-    for (uint32_t key = FRONTABLES_KEY_MIN; key <= FRONTABLES_KEY_MAX; key++) {
-        persist_delete(key);
-    }
-    for (uint32_t key = GROUPS_KEY_MIN; key <= GROUPS_KEY_MAX; key++) {
-        persist_delete(key);
+    for (uint8_t slot = 0; slot < CACHE_SLOT_COUNT; slot++) {
+        persist_delete(CACHE_SLOT_HEADER_KEY(slot));
+        for (uint8_t chunk = 0; chunk < CACHE_SLOT_MAX_CHUNKS; chunk++) {
+            persist_delete(CACHE_SLOT_CHUNK_KEY(slot, chunk));
+        }
     }
+
+    delete_legacy_keys();
+
+    active_slot = -1;
+    active_generation = 0;
 }
 
 void cache_persist_print_footprint() {
-    size_t pronoun_map_size = (sizeof(char) * COMPRESSED_PRONOUNS_LENGTH) * MAX_CACHED_PRONOUNS;
-    size_t frontables_size = sizeof(CompressedFrontable) * MAX_CACHED_FRONTABLES;
-    size_t groups_size = sizeof(CompressedGroup) * MAX_CACHED_GROUPS;
-    size_t total_size = pronoun_map_size + frontables_size + groups_size;
-
     APP_LOG(APP_LOG_LEVEL_INFO, "PERSRISTENT CACHE FOOTPRINT:");
-    APP_LOG(APP_LOG_LEVEL_INFO, "  pronoun map size: %lu b", (uint32_t)pronoun_map_size);
-    APP_LOG(APP_LOG_LEVEL_INFO, "  total frontables size: %lu b", (uint32_t)frontables_size);
-    APP_LOG(APP_LOG_LEVEL_INFO, "  total groups size: %lu b", (uint32_t)groups_size);
-    APP_LOG(APP_LOG_LEVEL_INFO, "  TOTAL FOOTPRINT: %lu b", (uint32_t)(total_size));
+
+    for (uint8_t slot = 0; slot < CACHE_SLOT_COUNT; slot++) {
+        CacheSlotHeader header;
+        if (read_slot_header(slot, &header)) {
+            APP_LOG(
+                APP_LOG_LEVEL_INFO,
+                "  slot %d: format %d, generation %lu, %d/%d b, %d frontables, %d groups, %d pronouns",
+                (int)slot,
+                (int)header.version,
+                header.generation,
+                (int)header.length,
+                CACHE_SLOT_MAX_BYTES,
+                (int)header.num_frontables,
+                (int)header.num_groups,
+                (int)header.num_pronouns
+            );
+        } else {
+            APP_LOG(APP_LOG_LEVEL_INFO, "  slot %d: empty", (int)slot);
+        }
+    }
+
+    size_t total_size = (CACHE_SLOT_MAX_BYTES + sizeof(CacheSlotHeader)) * CACHE_SLOT_COUNT;
+    APP_LOG(APP_LOG_LEVEL_INFO, "  MAX FOOTPRINT: %lu b", (uint32_t)(total_size));
 }
 
 void frontable_cache_deinit() {
     cache_clear_current_fronters();
     cache_clear_frontables();
     cache_clear_groups();
+    clear_sort_ranks();
+
+    // a sync may have been cut off halfway through
+    for (uint16_t i = 0; i < frontable_queue_count; i++) {
+        frontable_destroy(frontable_queue[i]);
+    }
 
     if (frontable_queue != NULL) {
-        free(frontable_queue);
+        heap_stats_free(frontable_queue);
         frontable_queue = NULL;
     }
     frontable_queue_count = 0;
 
     if (group_queue != NULL) {
-        free(group_queue);
+        heap_stats_free(group_queue);
         group_queue = NULL;
     }
     group_queue_count = 0;
 
     if (current_fronter_queue != NULL) {
-        free(current_fronter_queue);
+        heap_stats_free(current_fronter_queue);
         current_fronter_queue = NULL;
     }
     current_fronter_queue_count = 0;
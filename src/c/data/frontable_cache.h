@@ -9,11 +9,11 @@ FrontableList* cache_get_members();
 FrontableList* cache_get_custom_fronts();
 FrontableList* cache_get_current_fronters();
 Frontable* cache_get_first_fronter();
-Frontable* cache_get_frontable(uint32_t hash);
+Frontable* cache_get_frontable(uint16_t id);
 
-void cache_add_frontable(Frontable* frontable);
+bool cache_add_frontable(Frontable* frontable);
 void cache_clear_frontables();
-void cache_add_current_fronter(uint32_t hash, uint32_t start_time);
+void cache_add_current_fronter(uint16_t id, uint32_t start_time);
 void cache_clear_current_fronters();
 
 void cache_add_group(Group* group);
@@ -22,10 +22,14 @@ void cache_clear_groups();
 
 void cache_queue_add_frontable(Frontable* frontable);
 void cache_queue_add_group(Group* group);
-void cache_queue_add_current_fronter(uint32_t hash, uint32_t start_time);
+void cache_queue_add_current_fronter(uint16_t id, uint32_t start_time);
 void cache_queue_flush_frontables();
 void cache_queue_flush_groups();
 void cache_queue_flush_current_fronters();
+void cache_shed_pronouns();
+
+void cache_sort_list(FrontableList* list);
+void cache_apply_sort_order();
 
 void cache_persist_store();
 bool cache_persist_load();
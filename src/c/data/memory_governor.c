@@ -0,0 +1,101 @@
+#include "memory_governor.h"
+#include "frontable_cache.h"
+
+// left free for everything allocated after a sync lands: windows,
+//   menu layers, row layouts, sort orders and letter indices
+#define MEMORY_RESERVE_BYTES 3072
+
+// rough heap cost of each kind of data with malloc overhead, these
+//   only need to be close enough to pick a level before data arrives
+#define FRONTABLE_COST 72
+#define PRONOUNS_COST 8
+#define HIDDEN_ROOT_COST 6
+#define GROUP_MEMBERSHIP_COST 6
+#define GROUP_MENU_COST 320
+
+static MemoryLevel level = MEMORY_LEVEL_NORMAL;
+static uint16_t max_frontables = UINT16_MAX;
+
+static uint32_t get_projected_cost(MemoryLevel at, uint16_t num_frontables, uint16_t num_groups) {
+    uint32_t cost = (uint32_t)num_frontables * FRONTABLE_COST;
+
+    if (at < MEMORY_LEVEL_NO_PRONOUNS) {
+        cost += (uint32_t)num_frontables * PRONOUNS_COST;
+    }
+    if (at < MEMORY_LEVEL_NO_HIDDEN_ROOT) {
+        cost += (uint32_t)num_frontables * HIDDEN_ROOT_COST;
+    }
+    if (at < MEMORY_LEVEL_NO_GROUPS) {
+        cost += (uint32_t)num_frontables * GROUP_MEMBERSHIP_COST;
+        cost += (uint32_t)num_groups * GROUP_MENU_COST;
+    }
+
+    return cost;
+}
+
+static void set_level(MemoryLevel new_level, uint16_t new_max_frontables) {
+    // pronouns are the only thing already held that can be dropped
+    //   right away, everything else is shed when the sync is flushed
+    if (new_level >= MEMORY_LEVEL_NO_PRONOUNS && level < MEMORY_LEVEL_NO_PRONOUNS) {
+        cache_shed_pronouns();
+    }
+
+    if (new_level != level) {
+        APP_LOG(
+            APP_LOG_LEVEL_WARNING,
+            "WARNING: Memory level %d -> %d with %lu bytes free!",
+            (int)level,
+            (int)new_level,
+            (uint32_t)heap_bytes_free()
+        );
+    }
+
+    level = new_level;
+    max_frontables = new_max_frontables;
+}
+
+void memory_governor_begin_sync(uint16_t num_frontables, uint16_t num_groups) {
+    // the old data is only freed once the new data is flushed,
+    //   so everything incoming has to fit next to it
+    uint32_t free_bytes = heap_bytes_free();
+    uint32_t budget = free_bytes > MEMORY_RESERVE_BYTES ? free_bytes - MEMORY_RESERVE_BYTES : 0;
+
+    for (MemoryLevel at = MEMORY_LEVEL_NORMAL; at < MEMORY_LEVEL_TRUNCATED; at++) {
+        if (get_projected_cost(at, num_frontables, num_groups) <= budget) {
+            set_level(at, UINT16_MAX);
+            return;
+        }
+    }
+
+    uint32_t fitting = budget / FRONTABLE_COST;
+    set_level(MEMORY_LEVEL_TRUNCATED, fitting < num_frontables ? fitting : num_frontables);
+}
+
+void memory_governor_check(uint16_t num_received) {
+    if (heap_bytes_free() >= MEMORY_RESERVE_BYTES) return;
+
+    // the estimate was off, shed one more level. once truncating
+    //   there's nothing left to shed but the rest of the members
+    if (level < MEMORY_LEVEL_TRUNCATED - 1) {
+        set_level(level + 1, UINT16_MAX);
+    } else if (num_received < max_frontables) {
+        set_level(MEMORY_LEVEL_TRUNCATED, num_received);
+    }
+}
+
+void memory_governor_truncate(uint16_t num_received) {
+    // the heap is already out, nothing shed later would be in time
+    set_level(MEMORY_LEVEL_TRUNCATED, num_received < max_frontables ? num_received : max_frontables);
+}
+
+MemoryLevel memory_governor_get_level() {
+    return level;
+}
+
+bool memory_governor_is_shedding(MemoryLevel shed_level) {
+    return level >= shed_level;
+}
+
+uint16_t memory_governor_get_max_frontables() {
+    return max_frontables;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <pebble.h>
+
+// make sure these match the MemoryLevel enum in types.ts
+/// @brief How much optional data is shed to fit in memory, every level also sheds everything before it
+typedef enum {
+    MEMORY_LEVEL_NORMAL,
+    MEMORY_LEVEL_NO_PRONOUNS,
+    MEMORY_LEVEL_NO_HIDDEN_ROOT,
+    MEMORY_LEVEL_NO_GROUPS,
+    MEMORY_LEVEL_TRUNCATED,
+    MEMORY_LEVEL_COUNT
+} MemoryLevel;
+
+/// @brief Picks a level for an incoming sync from its size and the free heap, call when a data batch starts
+/// @param num_frontables Total frontables the phone has, before trimming to the last reported limits
+/// @param num_groups Total groups the phone has, before trimming to the last reported limits
+void memory_governor_begin_sync(uint16_t num_frontables, uint16_t num_groups);
+
+/// @brief Re-checks free heap while a batch comes in, escalating a level if it ran low
+/// @param num_received Frontables received so far in this sync
+void memory_governor_check(uint16_t num_received);
+
+/// @brief Truncates at what was received so far, call when allocating incoming data failed
+/// @param num_received Frontables received so far in this sync
+void memory_governor_truncate(uint16_t num_received);
+
+/// @brief Gets the current level
+/// @return Current memory level
+MemoryLevel memory_governor_get_level();
+
+/// @brief Gets whether or not data shed at a level is currently being shed
+/// @param level Level to check
+/// @return True if the current level is at or past the given level
+bool memory_governor_is_shedding(MemoryLevel level);
+
+/// @brief Gets how many frontables can be kept, frontables past this are dropped
+/// @return Max frontables, UINT16_MAX when not truncating
+uint16_t memory_governor_get_max_frontables();
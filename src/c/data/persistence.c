@@ -0,0 +1,73 @@
+#include "persistence.h"
+#include "config.h"
+#include "frecency.h"
+#include "frontable_cache.h"
+
+// how long the app has to go without new changes before dirty
+//   stores are written, a sync marks things dirty many times in a
+//   row so this coalesces all of those into a single write
+#define IDLE_FLUSH_DELAY_MS 3000
+
+static bool settings_dirty = false;
+static bool cache_dirty = false;
+static bool frecency_dirty = false;
+static AppTimer* idle_timer = NULL;
+
+static void idle_timer_callback(void* data) {
+    idle_timer = NULL;
+    persistence_flush();
+}
+
+static void schedule_flush() {
+    if (idle_timer == NULL) {
+        idle_timer = app_timer_register(IDLE_FLUSH_DELAY_MS, idle_timer_callback, NULL);
+    } else {
+        app_timer_reschedule(idle_timer, IDLE_FLUSH_DELAY_MS);
+    }
+}
+
+void persistence_mark_settings_dirty() {
+    settings_dirty = true;
+    schedule_flush();
+}
+
+void persistence_mark_cache_dirty() {
+    cache_dirty = true;
+    schedule_flush();
+}
+
+void persistence_mark_frecency_dirty() {
+    frecency_dirty = true;
+    schedule_flush();
+}
+
+void persistence_discard_cache() {
+    cache_dirty = false;
+    cache_persist_delete();
+}
+
+void persistence_flush() {
+    if (settings_dirty) {
+        settings_store();
+        settings_dirty = false;
+    }
+
+    if (cache_dirty) {
+        cache_persist_store();
+        cache_dirty = false;
+    }
+
+    if (frecency_dirty) {
+        frecency_store();
+        frecency_dirty = false;
+    }
+}
+
+void persistence_deinit() {
+    if (idle_timer != NULL) {
+        app_timer_cancel(idle_timer);
+        idle_timer = NULL;
+    }
+
+    persistence_flush();
+}
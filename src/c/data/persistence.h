@@ -0,0 +1,21 @@
+#pragma once
+
+#include <pebble.h>
+
+/// @brief Marks settings as changed, they will be written once the app goes idle
+void persistence_mark_settings_dirty();
+
+/// @brief Marks the frontable cache as changed, it will be written once the app goes idle
+void persistence_mark_cache_dirty();
+
+/// @brief Marks frecency scores as changed, they will be written once the app goes idle
+void persistence_mark_frecency_dirty();
+
+/// @brief Deletes the persisted frontable cache and drops any pending cache write
+void persistence_discard_cache();
+
+/// @brief Immediately writes any dirty stores to persistent storage
+void persistence_flush();
+
+/// @brief Cancels the idle timer and runs the final flush, call once on exit
+void persistence_deinit();
@@ -1,8 +1,19 @@
 #include "frontable.h"
+#include "../tools/heap_stats.h"
 #include "../tools/string_tools.h"
 
 #define NUM_COLORS 64
 
+// pronouns repeat a lot across a system, so every distinct string is
+//   only stored once and frontables point at the text of its entry
+typedef struct PronounEntry {
+    struct PronounEntry* next;
+    uint16_t refs;
+    char text[];
+} PronounEntry;
+
+static PronounEntry* pronoun_pool = NULL;
+
 static uint8_t colors[NUM_COLORS] = {
     GColorBlackARGB8,
     GColorOxfordBlueARGB8,
@@ -70,24 +81,82 @@ static uint8_t colors[NUM_COLORS] = {
     GColorWhiteARGB8
 };
 
-Frontable* frontable_create(uint32_t hash, const char* name, const char* pronouns, bool is_custom, GColor color) {
-    Frontable* f = malloc(sizeof(Frontable));
+static const char* pronouns_acquire(const char* pronouns) {
+    if (pronouns == NULL || pronouns[0] == '\0') return "";
+
+    // compare truncated, the same way it would be stored
+    char text[FRONTABLE_PRONOUNS_LENGTH];
+    string_safe_copy(text, pronouns, sizeof(text));
+
+    for (PronounEntry* entry = pronoun_pool; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->text, text) == 0) {
+            entry->refs++;
+            return entry->text;
+        }
+    }
+
+    size_t length = strlen(text) + 1;
+    PronounEntry* entry = heap_stats_malloc(HEAP_TAG_FRONTABLES, sizeof(PronounEntry) + length);
+    if (entry == NULL) {
+        // pronouns are optional, going without beats failing the frontable
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Not enough memory for pronouns '%s', dropping them!", text);
+        return "";
+    }
+
+    entry->refs = 1;
+    memcpy(entry->text, text, length);
+    entry->next = pronoun_pool;
+    pronoun_pool = entry;
+
+    return entry->text;
+}
+
+static void pronouns_release(const char* pronouns) {
+    PronounEntry** link = &pronoun_pool;
+    while (*link != NULL) {
+        PronounEntry* entry = *link;
+        if (entry->text == pronouns) {
+            entry->refs--;
+            if (entry->refs == 0) {
+                *link = entry->next;
+                heap_stats_free(entry);
+            }
+            return;
+        }
+
+        link = &entry->next;
+    }
+}
+
+Frontable* frontable_create(uint16_t id, const char* name, const char* pronouns, bool is_custom, GColor color) {
+    Frontable* f = heap_stats_malloc(HEAP_TAG_FRONTABLES, sizeof(Frontable));
+    if (f == NULL) return NULL;
+
     *f = (Frontable) {
-        .hash = hash,
+        .id = id,
         .packed_data = frontable_make_packed_data(false, is_custom, color),
-        .pronouns = {'\0'},
+        .pronouns = "",
         .group_bit_field = 0
     };
 
     string_safe_copy(f->name, name, FRONTABLE_NAME_LENGTH);
-
-    if (pronouns != NULL) {
-        string_safe_copy(f->pronouns, pronouns, FRONTABLE_PRONOUNS_LENGTH);
-    }
+    frontable_set_pronouns(f, pronouns);
 
     return f;
 }
 
+void frontable_destroy(Frontable* frontable) {
+    pronouns_release(frontable->pronouns);
+    heap_stats_free(frontable);
+}
+
+void frontable_set_pronouns(Frontable* frontable, const char* pronouns) {
+    // acquire first in case both point at the same entry
+    const char* acquired = pronouns_acquire(pronouns);
+    pronouns_release(frontable->pronouns);
+    frontable->pronouns = acquired;
+}
+
 uint8_t frontable_make_packed_data(bool fronting, bool is_custom, GColor color) {
     uint8_t data = 0;
     if (fronting) { data |= 0b10000000; }
@@ -4,12 +4,16 @@
 
 #define FRONTABLE_NAME_LENGTH 33
 #define FRONTABLE_PRONOUNS_LENGTH 17
+#define FRONTABLE_ID_NONE 0xFFFF
 
 /// @brief A struct that describes a frontable in a plural system, either a member or a custom front
 typedef struct {
     char name[FRONTABLE_NAME_LENGTH];
-    char pronouns[FRONTABLE_PRONOUNS_LENGTH];
-    uint32_t hash;
+
+    // shared between every frontable with the same pronouns, never NULL
+    //   ("" when there are none). only change through frontable_set_pronouns
+    const char* pronouns;
+
     uint32_t group_bit_field;
     uint32_t time_started_fronting;
 
@@ -18,16 +22,29 @@ typedef struct {
     //   1: whether or not frontable is a custom front
     //   2-7: color index
     uint8_t packed_data;
+
+    // position in the list the phone sent during the last sync,
+    //   custom fronts first. the phone maps these back to uuids
+    uint16_t id;
 } Frontable;
 
 /// @brief Creates a new Frontable on the heap
-/// @param hash Unique hash of this frontable
+/// @param id Dense id assigned by the phone during sync
 /// @param name Name of frontable
 /// @param pronouns Pronouns of frontable
 /// @param is_custom Whether or not frontable is a custom front
 /// @param color Color of frontable
-/// @return A pointer to a new Frontable allocated on the heap
-Frontable* frontable_create(uint32_t hash, const char* name, const char* pronouns, bool is_custom, GColor color);
+/// @return A pointer to a new Frontable allocated on the heap, NULL if out of memory
+Frontable* frontable_create(uint16_t id, const char* name, const char* pronouns, bool is_custom, GColor color);
+
+/// @brief Destroys a frontable, freeing memory from the heap
+/// @param frontable Frontable to destroy
+void frontable_destroy(Frontable* frontable);
+
+/// @brief Sets the pronouns of a frontable, sharing storage with any other frontable using the same pronouns
+/// @param frontable Frontable to set pronouns of
+/// @param pronouns Pronouns to set, NULL or empty to clear them
+void frontable_set_pronouns(Frontable* frontable, const char* pronouns);
 
 /// @brief Creates a packed 8-bit unsigned integer used for frontable data storing/compression
 /// @param fronting Whether or not frontable is currently fronting
@@ -1,61 +1,217 @@
 #include "frontable_list.h"
+#include "../tools/heap_stats.h"
 
-static void double_size(FrontableList* list) {
+#define LETTER_BUCKETS_MAX 255
+
+static void clear_letter_index(FrontableList* list) {
+    if (list->letter_buckets != NULL) {
+        heap_stats_free(list->letter_buckets);
+        list->letter_buckets = NULL;
+    }
+
+    list->num_letter_buckets = 0;
+}
+
+// letters are bucketed case-insensitively, everything else
+//   (numbers, symbols, non-ascii) shares one '#' bucket
+static char get_letter_key(const Frontable* frontable) {
+    char c = frontable->name[0];
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 'A';
+    } else if (c >= 'A' && c <= 'Z') {
+        return c;
+    }
+
+    return '#';
+}
+
+static void clear_order(FrontableList* list) {
+    if (list->order != NULL) {
+        heap_stats_free(list->order);
+        list->order = NULL;
+    }
+}
+
+// keeps the old array if growing fails, so the list stays usable
+static bool double_size(FrontableList* list) {
+    uint16_t new_size = list->frontables == NULL ? 1 : list->size * 2;
+
+    Frontable** resized = NULL;
     if (list->frontables == NULL) {
-        list->size = 1;
-        list->frontables = malloc(sizeof(Frontable*));
+        resized = heap_stats_malloc(HEAP_TAG_LISTS, sizeof(Frontable*) * new_size);
     } else {
-        list->size *= 2;
-        list->frontables = realloc(list->frontables, sizeof(Frontable*) * list->size);
+        resized = heap_stats_realloc(HEAP_TAG_LISTS, list->frontables, sizeof(Frontable*) * new_size);
+    }
 
-        if (list->frontables == NULL) {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR!!!!, Frontable list realloc failed!!!");
-        }
+    if (resized == NULL) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Frontable list could not grow past %u frontables!", list->size);
+        return false;
     }
+
+    list->frontables = resized;
+    list->size = new_size;
+    return true;
 }
 
 FrontableList* frontable_list_create() {
-    FrontableList* list = malloc(sizeof(FrontableList));
+    FrontableList* list = heap_stats_malloc(HEAP_TAG_LISTS, sizeof(FrontableList));
     *list = (FrontableList) {
         .frontables = NULL,
         .num_stored = 0,
-        .size = 0
+        .size = 0,
+        .letter_buckets = NULL,
+        .num_letter_buckets = 0,
+        .order = NULL
     };
     return list;
 }
 
 void frontable_list_destroy(FrontableList* list) {
     frontable_list_clear(list);
-    free(list);
+    heap_stats_free(list);
 }
 
-void frontable_list_add(Frontable* to_add, FrontableList* list) {
+bool frontable_list_add(Frontable* to_add, FrontableList* list) {
     while (list->num_stored >= list->size) {
-        double_size(list);
+        if (!double_size(list)) return false;
     }
 
     list->frontables[list->num_stored] = to_add;
     list->num_stored++;
+
+    // index and order no longer match the list
+    clear_letter_index(list);
+    clear_order(list);
+
+    return true;
 }
 
 void frontable_list_clear(FrontableList* list) {
     if (list->frontables != NULL) {
-        free(list->frontables);
+        heap_stats_free(list->frontables);
         list->frontables = NULL;
     }
 
     list->size = 0;
     list->num_stored = 0;
+
+    clear_letter_index(list);
+    clear_order(list);
 }
 
 void frontable_list_deep_clear(FrontableList* list) {
     for (uint16_t i = 0; i < list->num_stored; i++) {
-        free(list->frontables[i]);
+        frontable_destroy(list->frontables[i]);
     }
 
     frontable_list_clear(list);
 }
 
+Frontable* frontable_list_get_sorted(FrontableList* list, uint16_t index) {
+    return list->frontables[frontable_list_get_stored_index(list, index)];
+}
+
+uint16_t frontable_list_get_stored_index(FrontableList* list, uint16_t index) {
+    if (list->order != NULL) {
+        return list->order[index];
+    }
+
+    return index;
+}
+
+static uint16_t get_rank(FrontableList* list, uint16_t index, const uint16_t* ranks, uint16_t num_ranks) {
+    uint16_t id = list->frontables[index]->id;
+    return id < num_ranks ? ranks[id] : UINT16_MAX;
+}
+
+void frontable_list_apply_ranks(FrontableList* list, const uint16_t* ranks, uint16_t num_ranks) {
+    clear_order(list);
+    if (ranks == NULL || list->num_stored == 0) return;
+
+    list->order = heap_stats_malloc(HEAP_TAG_LISTS, sizeof(uint16_t) * list->num_stored);
+    if (list->order == NULL) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Not enough memory for list order, keeping stored order!");
+        return;
+    }
+
+    // insertion sort, lists are small and this only runs
+    //   when the order or the list itself changes
+    for (uint16_t i = 0; i < list->num_stored; i++) {
+        uint16_t rank = get_rank(list, i, ranks, num_ranks);
+
+        uint16_t j = i;
+        while (j > 0 && get_rank(list, list->order[j - 1], ranks, num_ranks) > rank) {
+            list->order[j] = list->order[j - 1];
+            j--;
+        }
+
+        list->order[j] = i;
+    }
+}
+
+void frontable_list_build_letter_index(FrontableList* list) {
+    clear_letter_index(list);
+    if (list->num_stored == 0) return;
+
+    // count runs first so the index is allocated at its exact size
+    uint16_t num_buckets = 1;
+    for (uint16_t i = 1; i < list->num_stored; i++) {
+        if (get_letter_key(frontable_list_get_sorted(list, i)) != get_letter_key(frontable_list_get_sorted(list, i - 1))) {
+            num_buckets++;
+        }
+    }
+    if (num_buckets > LETTER_BUCKETS_MAX) num_buckets = LETTER_BUCKETS_MAX;
+
+    list->letter_buckets = heap_stats_malloc(HEAP_TAG_LISTS, sizeof(LetterBucket) * num_buckets);
+    if (list->letter_buckets == NULL) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Not enough memory for letter index!");
+        return;
+    }
+
+    char prev_key = '\0';
+    for (uint16_t i = 0; i < list->num_stored; i++) {
+        char key = get_letter_key(frontable_list_get_sorted(list, i));
+        if (i > 0 && key == prev_key) continue;
+        if (list->num_letter_buckets >= num_buckets) break;
+
+        list->letter_buckets[list->num_letter_buckets] = (LetterBucket) {
+            .letter = key,
+            .start = i
+        };
+        list->num_letter_buckets++;
+        prev_key = key;
+    }
+}
+
+int32_t frontable_list_get_letter_jump(FrontableList* list, uint16_t index, bool forward) {
+    if (list->letter_buckets == NULL || list->num_letter_buckets == 0) {
+        return index;
+    }
+
+    // find the bucket the index is in
+    uint8_t bucket = 0;
+    while (bucket + 1 < list->num_letter_buckets && list->letter_buckets[bucket + 1].start <= index) {
+        bucket++;
+    }
+
+    if (forward) {
+        if (bucket + 1 < list->num_letter_buckets) {
+            return list->letter_buckets[bucket + 1].start;
+        }
+
+        return list->num_stored - 1;
+    }
+
+    // back to the start of this letter first, then the letter before it
+    if (index > list->letter_buckets[bucket].start) {
+        return list->letter_buckets[bucket].start;
+    } else if (bucket > 0) {
+        return list->letter_buckets[bucket - 1].start;
+    }
+
+    return -1;
+}
+
 bool frontable_list_contains(FrontableList* list, Frontable* frontable) {
     for (uint16_t i = 0; i < list->num_stored; i++) {
         if (list->frontables[i] == frontable) {
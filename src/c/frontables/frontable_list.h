@@ -3,11 +3,24 @@
 #include "frontable.h"
 #include <pebble.h>
 
+/// @brief A run of frontables in a list whose names start with the same letter
+typedef struct {
+    char letter;
+    uint16_t start;
+} LetterBucket;
+
 /// @brief A struct representing a dynamic array of frontables
 typedef struct {
     Frontable** frontables;
     uint16_t size;
     uint16_t num_stored;
+
+    // first-letter jump index, NULL until built and after the list changes
+    LetterBucket* letter_buckets;
+    uint8_t num_letter_buckets;
+
+    // display order as indices into frontables, NULL shows them as stored
+    uint16_t* order;
 } FrontableList;
 
 /// @brief Creates a new frontable list on the heap
@@ -21,7 +34,8 @@ void frontable_list_destroy(FrontableList* list);
 /// @brief Adds a frontable to the end of a frontable list
 /// @param to_add Frontable to add
 /// @param list List to add to
-void frontable_list_add(Frontable* to_add, FrontableList* list);
+/// @return True if added, false if the list couldn't grow
+bool frontable_list_add(Frontable* to_add, FrontableList* list);
 
 /// @brief Clears a frontable list, does not free memory of contained frontables
 /// @param list List to clear
@@ -31,6 +45,35 @@ void frontable_list_clear(FrontableList* list);
 /// @param list List to clear
 void frontable_list_deep_clear(FrontableList* list);
 
+/// @brief Gets a frontable by its position in the list's display order
+/// @param list List to get frontable from
+/// @param index Index in display order
+/// @return Pointer to frontable at that position
+Frontable* frontable_list_get_sorted(FrontableList* list, uint16_t index);
+
+/// @brief Gets where a frontable in display order is actually stored in the list
+/// @param list List to look in
+/// @param index Index in display order
+/// @return Index into the list's stored frontables
+uint16_t frontable_list_get_stored_index(FrontableList* list, uint16_t index);
+
+/// @brief Sets the display order of a list from per-id ranks, without moving stored frontables
+/// @param list List to order
+/// @param ranks Rank of every frontable indexed by id, NULL to display in stored order
+/// @param num_ranks Length of the ranks array, frontables with ids past it go last
+void frontable_list_apply_ranks(FrontableList* list, const uint16_t* ranks, uint16_t num_ranks);
+
+/// @brief Builds the first-letter jump index of an already sorted list, replacing any old index
+/// @param list List to build index for
+void frontable_list_build_letter_index(FrontableList* list);
+
+/// @brief Finds where a letter jump from an index lands using the letter index
+/// @param list List to jump through
+/// @param index Index currently selected in the list
+/// @param forward True to jump to the next letter, false to jump back to the start of this (or the previous) letter
+/// @return Index to jump to, -1 if the jump goes before the start of the list
+int32_t frontable_list_get_letter_jump(FrontableList* list, uint16_t index, bool forward);
+
 /// @brief Gets whether or not a frontable list contains a frontable
 /// @param list List to check contents of
 /// @param frontable Frontable to check if existing
@@ -1,11 +1,12 @@
 #include "group.h"
 
+#include "../tools/heap_stats.h"
 #include "../tools/string_tools.h"
 
 Group* group_create(const char* name, GColor color, Group* parent) {
     FrontableList* frontables = frontable_list_create();
 
-    Group* group = malloc(sizeof(Group));
+    Group* group = heap_stats_malloc(HEAP_TAG_GROUPS, sizeof(Group));
     *group = (Group) {
         .color = color,
         .frontables = frontables,
@@ -18,5 +19,5 @@ Group* group_create(const char* name, GColor color, Group* parent) {
 
 void group_destroy(Group* group) {
     frontable_list_destroy(group->frontables);
-    free(group);
+    heap_stats_free(group);
 }
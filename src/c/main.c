@@ -1,8 +1,12 @@
 #include "data/config.h"
+#include "data/frecency.h"
 #include "data/frontable_cache.h"
+#include "data/persistence.h"
 #include "menus/current_fronters_menu.h"
 #include "menus/custom_fronts_menu.h"
 #include "menus/error_menu.h"
+#include "menus/frontable_menu.h"
+#include "menus/heap_stats_menu.h"
 #include "menus/main_menu.h"
 #include "menus/members_menu.h"
 #include "menus/settings_menu.h"
@@ -10,20 +14,64 @@
 #include "messaging/messaging.h"
 #include <pebble.h>
 
-static void connection_handler(bool connected) {
+// bluetooth flaps a lot, only act on a connection change once
+//   it's held for this long
+#define CONNECTION_DEBOUNCE_MS 3000
+
+static bool connected = false;
+static AppTimer* connection_timer = NULL;
+
+static void push_root_menu() {
+    window_stack_pop_all(false);
+
+    if (settings_get()->api_key_valid) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "Pushing main menu!");
+        main_menu_push();
+    } else {
+        APP_LOG(APP_LOG_LEVEL_INFO, "API key invalid, pushing setup menu!");
+        setup_prompt_menu_push();
+    }
+}
+
+static void set_offline(bool offline) {
+    main_menu_set_offline(offline);
+    frontable_menu_set_offline(offline);
+
+    Window* top_window = window_stack_get_top_window();
+    if (top_window != NULL) {
+        layer_mark_dirty(window_get_root_layer(top_window));
+    }
+}
+
+static void connection_settled(void* data) {
+    connection_timer = NULL;
+
+    bool now_connected = connection_service_peek_pebble_app_connection();
+    if (now_connected == connected) return;
+    connected = now_connected;
+
     if (connected) {
-        window_stack_pop_all(false);
-
-        if (settings_get()->api_key_valid) {
-            APP_LOG(APP_LOG_LEVEL_INFO, "Phone reconnected, pushing main menu!");
-            main_menu_push();
-        } else {
-            APP_LOG(APP_LOG_LEVEL_INFO, "Phone reconnected but api key invalid, pushing setup menu!");
-            setup_prompt_menu_push();
+        APP_LOG(APP_LOG_LEVEL_INFO, "Phone reconnected, catching up!");
+        set_offline(false);
+
+        // the error screen only shows when there was nothing to
+        //   browse offline, otherwise the stack is left as it was
+        if (error_menu_shown()) {
+            push_root_menu();
         }
+
+        messaging_request_catch_up();
     } else {
-        APP_LOG(APP_LOG_LEVEL_INFO, "Phone disconnected, pushing disconnected menu!");
-        error_menu_show("phone is not\nconnected :[");
+        APP_LOG(APP_LOG_LEVEL_INFO, "Phone disconnected, showing offline indicator!");
+        set_offline(true);
+    }
+}
+
+static void connection_handler(bool is_connected) {
+    if (connection_timer == NULL) {
+        connection_timer = app_timer_register(CONNECTION_DEBOUNCE_MS, connection_settled, NULL);
+    } else {
+        app_timer_reschedule(connection_timer, CONNECTION_DEBOUNCE_MS);
     }
 }
 
@@ -37,7 +85,9 @@ static void init() {
 
     messaging_init();
     settings_load();
-    if (cache_persist_load()) {
+    frecency_load();
+    bool cache_loaded = cache_persist_load();
+    if (cache_loaded) {
         main_menu_mark_members_loaded();
         main_menu_mark_custom_fronts_loaded();
         main_menu_mark_fronters_loaded();
@@ -49,18 +99,29 @@ static void init() {
         .pebble_app_connection_handler = connection_handler
     });
 
-    // push the appropriate menu depending on current watch connection status
-    connection_handler(connection_service_peek_pebble_app_connection());
+    // cached data can be browsed without the phone, only fall back
+    //   to the error screen when there's nothing to show at all
+    connected = connection_service_peek_pebble_app_connection();
+    if (connected || cache_loaded) {
+        push_root_menu();
+        set_offline(!connected);
+    } else {
+        APP_LOG(APP_LOG_LEVEL_INFO, "Phone not connected and nothing cached, pushing disconnected menu!");
+        error_menu_show("phone is not\nconnected :[");
+    }
 
     main_menu_update_fronters_subtitle();
     main_menu_update_fetch_status(true);
 }
 
 static void deinit() {
-    settings_save(false);
-    cache_persist_store();
+    persistence_deinit();
 
     connection_service_unsubscribe();
+    if (connection_timer != NULL) {
+        app_timer_cancel(connection_timer);
+        connection_timer = NULL;
+    }
 
     members_menu_deinit();
     custom_fronts_menu_deinit();
@@ -68,9 +129,12 @@ static void deinit() {
     main_menu_deinit();
     frontable_cache_deinit();
     settings_menu_deinit();
+    heap_stats_menu_deinit();
     error_menu_deinit();
 
     setup_prompt_menu_remove();
+
+    messaging_deinit();
 }
 
 int main() {
@@ -4,17 +4,66 @@
 
 // static const bool DRAW_TIME = false;
 
+// fronts at least this long drop seconds and show days instead
+#define LONG_FRONT_SECONDS (24 * 60 * 60)
+
 static FrontableMenu* menu = NULL;
 static TextLayer* text_layer = NULL;
 static Group group;
 static bool empty = false;
+static bool visible = false;
+
+// 0 when not subscribed to the tick timer at all
+static TimeUnits tick_units = 0;
+
+static void update_tick_subscription();
 
 static void tick_handler(struct tm* tick_time, TimeUnits units_changed) {
-    if (menu != NULL) {
-        Window* window = frontable_menu_get_window(menu);
-        Layer* root = window_get_root_layer(window);
-        layer_mark_dirty(root);
+    if (menu == NULL) return;
+
+    // only the time labels change between ticks, and row layouts are
+    //   cached, so just the menu needs redrawing (not the status bar)
+    MenuLayer* menu_layer = frontable_menu_get_menu_layer(menu);
+    if (menu_layer != NULL) {
+        layer_mark_dirty(menu_layer_get_layer(menu_layer));
+    }
+
+    // fronts may have just crossed into the coarser day format
+    update_tick_subscription();
+}
+
+static TimeUnits get_needed_tick_units() {
+    bool time_shown = settings_get()->show_time_fronting && !settings_get()->compact_member_list;
+    if (!visible || !time_shown || empty) {
+        return 0;
+    }
+
+    // seconds are only drawn for fronts shorter than a day
+    time_t time_now = time(NULL);
+    FrontableList* fronters = cache_get_current_fronters();
+    for (uint16_t i = 0; i < fronters->num_stored; i++) {
+        uint32_t started = fronters->frontables[i]->time_started_fronting;
+        if (started != 0 && (uint32_t)time_now - started < LONG_FRONT_SECONDS) {
+            return SECOND_UNIT;
+        }
+    }
+
+    return MINUTE_UNIT;
+}
+
+static void update_tick_subscription() {
+    TimeUnits units = get_needed_tick_units();
+    if (units == tick_units) {
+        return;
+    }
+
+    if (units == 0) {
+        tick_timer_service_unsubscribe();
+    } else {
+        tick_timer_service_subscribe(units, tick_handler);
     }
+
+    tick_units = units;
 }
 
 static void draw_row(
@@ -34,23 +83,34 @@ static void draw_row(
     time_t time_now = 0;
     time_ms(&time_now, NULL);
 
-    // HH:MM:SS
+    // H:MM:SS, or Nd H:MM once fronting for a day or more
     char time_fronting_str[16] = {'\0'};
 
     uint32_t diff = time_now - selected_frontable->time_started_fronting;
     uint32_t hours = diff / 60 / 60;
     uint32_t minutes = (diff - (hours * 60 * 60)) / 60;
     uint32_t seconds = (diff - (minutes * 60) - (hours * 60 * 60));
-    snprintf(
-        time_fronting_str,
-        sizeof(time_fronting_str),
-        "%lu:%02lu:%02lu",
-        hours,
-        minutes,
-        seconds
-    );
+    if (diff >= LONG_FRONT_SECONDS) {
+        snprintf(
+            time_fronting_str,
+            sizeof(time_fronting_str),
+            "%lud %lu:%02lu",
+            hours / 24,
+            hours % 24,
+            minutes
+        );
+    } else {
+        snprintf(
+            time_fronting_str,
+            sizeof(time_fronting_str),
+            "%lu:%02lu:%02lu",
+            hours,
+            minutes,
+            seconds
+        );
+    }
 
-    char* bl_text = NULL;
+    const char* bl_text = NULL;
     if (frontable_get_is_custom(selected_frontable)) {
         if (settings_get()->custom_front_text[0] != '\0') {
             bl_text = settings_get()->custom_front_text;
@@ -105,17 +165,22 @@ static void window_load(Window* window) {
     } else {
         empty = false;
     }
-
-    if (settings_get()->show_time_fronting) {
-        tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
-    }
 }
 
 static void window_unload(Window* window) {
     text_layer_destroy(text_layer);
     text_layer = NULL;
+}
+
+// only tick while the fronters window is actually on top
+static void window_appear(Window* window) {
+    visible = true;
+    update_tick_subscription();
+}
 
-    tick_timer_service_unsubscribe();
+static void window_disappear(Window* window) {
+    visible = false;
+    update_tick_subscription();
 }
 
 void current_fronters_menu_push() {
@@ -124,7 +189,9 @@ void current_fronters_menu_push() {
             .draw_row = draw_row,
             .select = menu_select,
             .window_load = window_load,
-            .window_unload = window_unload
+            .window_unload = window_unload,
+            .window_appear = window_appear,
+            .window_disappear = window_disappear
         };
 
         group.color = settings_get()->background_color;
@@ -157,9 +224,15 @@ void current_fronters_menu_update_colors() {
         text_layer_set_background_color(text_layer, settings_get()->background_color);
         text_layer_set_text_color(text_layer, gcolor_legible_over(settings_get()->background_color));
     }
+
+    // showing time or compact mode may have been toggled
+    update_tick_subscription();
 }
 
 void current_fronters_menu_update_is_empty() {
+    // fronters changed, their start times decide the tick rate
+    update_tick_subscription();
+
     // don't update anything if text layer doesn't exist lol
     if (text_layer == NULL) {
         return;
@@ -189,4 +262,6 @@ void current_fronters_menu_update_is_empty() {
     // mark to redraw every update, update boolean flag
     empty = current_is_empty;
     layer_mark_dirty(root_layer);
+
+    update_tick_subscription();
 }
@@ -74,6 +74,10 @@ void error_menu_push() {
     window_stack_push(window, true);
 }
 
+bool error_menu_shown() {
+    return window != NULL && window_stack_contains_window(window);
+}
+
 void error_menu_deinit() {
     if (window != NULL) {
         window_destroy(window);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <pebble.h>
+
 void error_menu_push();
 void error_menu_deinit();
 void error_menu_show(const char* text);
+bool error_menu_shown();
@@ -1,7 +1,37 @@
 #include "frontable_menu.h"
 #include "../messaging/messaging.h"
+#include "../tools/heap_stats.h"
+#include "../tools/string_tools.h"
+#include "../tools/trace.h"
 
 #define TREE_MAX_CHILD_COUNT 64
+#define LONG_CLICK_DELAY_MS 500
+#define CHECKBOX_SIZE 11
+
+// rows are cached direct-mapped by row index, comfortably more
+//   than the number of rows visible on any platform
+#define ROW_LAYOUT_CACHE_SIZE 8
+
+typedef struct {
+    // frontable or group shown in the row, only compared never read
+    const void* key;
+    uint16_t generation;
+    GSize cell_size;
+
+    GSize main_size;
+    GSize bottom_left_size;
+    GSize bottom_right_size;
+    GRect main_box;
+    GRect bottom_left_box;
+    GRect bottom_right_box;
+    bool draw_bl;
+    bool draw_br;
+
+    // bottom left text can go away under the same key (pronouns shed)
+    bool has_bl;
+    bool has_br;
+    char bottom_right_text[16];
+} RowLayout;
 
 struct GroupTreeNode;
 typedef struct GroupTreeNode {
@@ -19,6 +49,8 @@ struct FrontableMenu {
     MenuLayer* menu_layer;
     ActionMenuLevel* non_fronting_action_level;
     ActionMenuLevel* fronting_action_level;
+    ActionMenuLevel* multi_select_action_level;
+    ActionMenuLevel* group_action_level;
     ActionMenuConfig action_menu_config;
 
     TextLayer* status_bar_text;
@@ -26,12 +58,35 @@ struct FrontableMenu {
 
     GroupTreeNode group_node;
 
-    uint32_t selected_frontable_hash;
+    uint16_t selected_frontable_id;
+    GroupTreeNode* selected_group_node;
     GColor highlight_color;
 
+    // multi-select checks are bits over stored list positions so
+    //   re-sorting doesn't move them, only allocated while selecting
+    bool multi_select;
+    uint8_t* checked;
+    uint16_t checked_capacity;
+    uint16_t num_checked;
+    char status_text[24];
+
     uint16_t index_on_load;
+
+    // only allocated while the window is loaded
+    RowLayout* row_layouts;
+    const void* drawing_key;
+    uint16_t drawing_row;
+    bool drawing_checkbox;
+    bool drawing_checked;
 };
 
+// bumped whenever settings or cached data change, stale layouts
+//   are detected by comparing against this on draw
+static uint16_t layout_generation = 1;
+
+// shared by every menu, shown as a small hollow dot in the status bar
+static bool offline = false;
+
 // ~~~ HELPER FUNCTIONS ~~~
 
 static void update_selected_highlight(FrontableMenu* menu, uint16_t index) {
@@ -47,7 +102,7 @@ static void update_selected_highlight(FrontableMenu* menu, uint16_t index) {
             // otherwise try to get color of selected frontable
             int16_t i = index - menu->group_node.num_children;
             if (i >= 0 && i < frontables->num_stored) {
-                Frontable* f = frontables->frontables[i];
+                Frontable* f = frontable_list_get_sorted(frontables, i);
                 color = frontable_get_color(f);
             }
         }
@@ -60,6 +115,16 @@ static void update_selected_highlight(FrontableMenu* menu, uint16_t index) {
     menu->highlight_color = color;
 }
 
+static void apply_highlight_colors(FrontableMenu* menu) {
+    if (menu->menu_layer == NULL) return;
+
+    menu_layer_set_highlight_colors(
+        menu->menu_layer,
+        menu->highlight_color,
+        gcolor_legible_over(menu->highlight_color)
+    );
+}
+
 static void window_pop_recursive(FrontableMenu* menu, bool pop_root, bool animated) {
     GroupTreeNode* parent = menu->group_node.parent;
 
@@ -83,6 +148,124 @@ static void window_push_recursive(FrontableMenu* menu, Window* root_limit) {
     window_stack_push(menu->window, false);
 }
 
+// ~~~ MULTI-SELECT ~~~
+
+// returns -1 if the row isn't a frontable
+static int32_t get_row_stored_index(FrontableMenu* menu, uint16_t row) {
+    FrontableList* frontables = menu->group_node.group->frontables;
+    int32_t i = row - menu->group_node.num_children;
+    if (i < 0 || i >= frontables->num_stored) {
+        return -1;
+    }
+
+    return frontable_list_get_stored_index(frontables, i);
+}
+
+static bool is_row_checked(FrontableMenu* menu, uint16_t row) {
+    int32_t i = get_row_stored_index(menu, row);
+    if (menu->checked == NULL || i < 0 || i >= menu->checked_capacity) {
+        return false;
+    }
+
+    return ((menu->checked[i / 8] >> (i % 8)) & 1) != 0;
+}
+
+static void update_multi_select_status(FrontableMenu* menu) {
+    if (menu->status_bar_text == NULL) return;
+
+    if (menu->multi_select) {
+        snprintf(menu->status_text, sizeof(menu->status_text), "%u selected", menu->num_checked);
+        text_layer_set_text(menu->status_bar_text, menu->status_text);
+    } else {
+        text_layer_set_text(menu->status_bar_text, menu->group_node.group->name);
+    }
+}
+
+static void toggle_row_checked(FrontableMenu* menu, uint16_t row) {
+    int32_t i = get_row_stored_index(menu, row);
+    if (menu->checked == NULL || i < 0 || i >= menu->checked_capacity) return;
+
+    menu->checked[i / 8] ^= 1 << (i % 8);
+    if (is_row_checked(menu, row)) {
+        menu->num_checked++;
+    } else {
+        menu->num_checked--;
+    }
+
+    update_multi_select_status(menu);
+    layer_mark_dirty(menu_layer_get_layer(menu->menu_layer));
+}
+
+static void multi_select_end(FrontableMenu* menu) {
+    if (menu->checked != NULL) {
+        heap_stats_free(menu->checked);
+        menu->checked = NULL;
+    }
+
+    menu->multi_select = false;
+    menu->checked_capacity = 0;
+    menu->num_checked = 0;
+
+    update_multi_select_status(menu);
+    if (menu->menu_layer != NULL) {
+        layer_mark_dirty(menu_layer_get_layer(menu->menu_layer));
+    }
+}
+
+static void multi_select_begin(FrontableMenu* menu) {
+    FrontableList* frontables = menu->group_node.group->frontables;
+    if (frontables->num_stored == 0) return;
+
+    uint16_t num_bytes = (frontables->num_stored + 7) / 8;
+    menu->checked = heap_stats_malloc(HEAP_TAG_MENUS, num_bytes);
+    if (menu->checked == NULL) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Not enough memory to multi-select!");
+        return;
+    }
+
+    memset(menu->checked, 0, num_bytes);
+    menu->checked_capacity = frontables->num_stored;
+    menu->num_checked = 0;
+    menu->multi_select = true;
+}
+
+// sends every frontable of a list matching the mask (or all if NULL)
+//   as one front list, so the phone makes a single switch. false if
+//   nothing was sent and the menus should stay where they are
+static bool send_front_list(FrontableList* frontables, const uint8_t* mask, uint16_t mask_capacity) {
+    uint16_t* ids = heap_stats_malloc(HEAP_TAG_MENUS, sizeof(uint16_t) * frontables->num_stored);
+    if (ids == NULL) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Not enough memory to send front list!");
+        return false;
+    }
+
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < frontables->num_stored; i++) {
+        if (mask != NULL && (i >= mask_capacity || ((mask[i / 8] >> (i % 8)) & 1) == 0)) {
+            continue;
+        }
+
+        ids[count++] = frontables->frontables[i]->id;
+    }
+
+    bool sent = messaging_set_front_list(ids, count);
+    heap_stats_free(ids);
+
+    return sent;
+}
+
+static void open_action_menu(FrontableMenu* menu, ActionMenuLevel* level, GColor accent) {
+    // same legibility fix as single frontable actions
+    if ((accent.argb & 0b00111111) == 0) {
+        accent = GColorDarkGray;
+    }
+
+    menu->action_menu_config.colors.background = accent;
+    menu->action_menu_config.colors.foreground = gcolor_legible_over(accent);
+    menu->action_menu_config.root_level = level;
+    action_menu_open(&menu->action_menu_config);
+}
+
 // ~~~ MENU LAYER SETUP ~~~
 
 static uint16_t get_num_rows(MenuLayer* layer, uint16_t section_index, void* context) {
@@ -113,6 +296,7 @@ static uint16_t get_num_sections(MenuLayer* menu_layer, void* context) {
 
 static void draw_row(GContext* ctx, const Layer* cell_layer, MenuIndex* cell_index, void* context) {
     FrontableMenu* menu = (FrontableMenu*)context;
+    trace_first_draw();
 
     Group* group = NULL;
     Frontable* frontable = NULL;
@@ -123,11 +307,19 @@ static void draw_row(GContext* ctx, const Layer* cell_layer, MenuIndex* cell_ind
         int16_t i = cell_index->row - menu->group_node.num_children;
         FrontableList* frontables = menu->group_node.group->frontables;
         if (i >= 0 && i < frontables->num_stored) {
-            frontable = frontables->frontables[i];
+            frontable = frontable_list_get_sorted(frontables, i);
         }
     }
 
+    menu->drawing_key = frontable != NULL ? (const void*)frontable : (const void*)group;
+    menu->drawing_row = cell_index->row;
+    menu->drawing_checkbox = menu->multi_select && frontable != NULL;
+    menu->drawing_checked = menu->drawing_checkbox && is_row_checked(menu, cell_index->row);
+
     menu->callbacks.draw_row(menu, ctx, cell_layer, frontable, group);
+
+    menu->drawing_key = NULL;
+    menu->drawing_checkbox = false;
 }
 
 static void selection_changed(MenuLayer* layer, MenuIndex new_index, MenuIndex old_index, void* context) {
@@ -135,18 +327,118 @@ static void selection_changed(MenuLayer* layer, MenuIndex new_index, MenuIndex o
 
     if (menu != NULL) {
         update_selected_highlight(menu, new_index.row);
+        apply_highlight_colors(menu);
     }
 
     menu->index_on_load = new_index.row;
-    menu->selected_frontable_hash = 0;
+    menu->selected_frontable_id = FRONTABLE_ID_NONE;
 
     int16_t i = new_index.row - menu->group_node.num_children;
     FrontableList* frontables = menu->group_node.group->frontables;
     if (i >= 0 && i < frontables->num_stored) {
-        menu->selected_frontable_hash = frontables->frontables[i]->hash;
+        menu->selected_frontable_id = frontable_list_get_sorted(frontables, i)->id;
     }
 }
 
+// ~~~ CLICK HANDLING ~~~
+//
+// up/down step one row like a regular menu layer, holding up/down
+//   jumps between first letters of the frontable list instead
+
+static void click_up(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    menu_layer_set_selected_next(menu->menu_layer, true, MenuRowAlignCenter, true);
+}
+
+static void click_down(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    menu_layer_set_selected_next(menu->menu_layer, false, MenuRowAlignCenter, true);
+}
+
+static void long_click_jump(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    bool forward = click_recognizer_get_button_id(recognizer) == BUTTON_ID_DOWN;
+
+    FrontableList* frontables = menu->group_node.group->frontables;
+    uint16_t num_children = menu->group_node.num_children;
+    uint16_t row = menu_layer_get_selected_index(menu->menu_layer).row;
+
+    // group rows come before frontables and count as one bucket
+    int32_t target = row;
+    if (row < num_children) {
+        target = forward && frontables->num_stored > 0 ? num_children : 0;
+    } else if (frontables->num_stored > 0) {
+        int32_t jump = frontable_list_get_letter_jump(frontables, row - num_children, forward);
+        target = jump < 0 ? 0 : jump + num_children;
+    }
+
+    if (target != row) {
+        menu_layer_set_selected_index(
+            menu->menu_layer,
+            (MenuIndex) {.row = target},
+            MenuRowAlignCenter,
+            false
+        );
+    }
+}
+
+static void click_select(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    MenuIndex index = menu_layer_get_selected_index(menu->menu_layer);
+
+    // frontable rows toggle while multi-selecting, groups still open
+    if (menu->multi_select && get_row_stored_index(menu, index.row) >= 0) {
+        toggle_row_checked(menu, index.row);
+        return;
+    }
+
+    menu->callbacks.select(menu->menu_layer, &index, menu);
+}
+
+// holding select starts multi-select on frontables, opens the
+//   selection actions while selecting, and group actions on groups
+static void long_click_select(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    uint16_t row = menu_layer_get_selected_index(menu->menu_layer).row;
+
+    if (row < menu->group_node.num_children) {
+        GroupTreeNode* node = menu->group_node.children[row];
+        if (node->group->frontables->num_stored > 0) {
+            menu->selected_group_node = node;
+            open_action_menu(menu, menu->group_action_level, node->group->color);
+        }
+    } else if (menu->multi_select) {
+        if (menu->num_checked > 0) {
+            open_action_menu(menu, menu->multi_select_action_level, settings_get_global_accent());
+        } else {
+            multi_select_end(menu);
+        }
+    } else {
+        multi_select_begin(menu);
+        toggle_row_checked(menu, row);
+    }
+}
+
+static void click_back(ClickRecognizerRef recognizer, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+
+    if (menu->multi_select) {
+        multi_select_end(menu);
+    } else {
+        window_stack_remove(menu->window, true);
+    }
+}
+
+static void click_config_provider(void* context) {
+    window_single_click_subscribe(BUTTON_ID_UP, click_up);
+    window_single_click_subscribe(BUTTON_ID_DOWN, click_down);
+    window_long_click_subscribe(BUTTON_ID_UP, LONG_CLICK_DELAY_MS, long_click_jump, NULL);
+    window_long_click_subscribe(BUTTON_ID_DOWN, LONG_CLICK_DELAY_MS, long_click_jump, NULL);
+    window_single_click_subscribe(BUTTON_ID_SELECT, click_select);
+    window_long_click_subscribe(BUTTON_ID_SELECT, LONG_CLICK_DELAY_MS, long_click_select, NULL);
+    window_single_click_subscribe(BUTTON_ID_BACK, click_back);
+}
+
 static void status_bar_update_proc(Layer* layer, GContext* ctx) {
     Window* window = layer_get_window(layer);
     FrontableMenu* menu = (FrontableMenu*)window_get_user_data(window);
@@ -158,6 +450,17 @@ static void status_bar_update_proc(Layer* layer, GContext* ctx) {
 
     graphics_context_set_fill_color(ctx, bg);
     graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+
+    if (offline) {
+        GRect bounds = layer_get_bounds(layer);
+        GPoint center = GPoint(
+            PBL_IF_ROUND_ELSE(bounds.size.w / 2, bounds.size.w - 8),
+            PBL_IF_ROUND_ELSE(bounds.size.h - 4, bounds.size.h / 2)
+        );
+
+        graphics_context_set_stroke_color(ctx, gcolor_legible_over(bg));
+        graphics_draw_circle(ctx, center, 3);
+    }
 }
 
 static void menu_layer_setup(FrontableMenu* menu) {
@@ -187,7 +490,7 @@ static void menu_layer_setup(FrontableMenu* menu) {
         }
     );
 
-    menu_layer_set_click_config_onto_window(menu->menu_layer, menu->window);
+    window_set_click_config_provider_with_context(menu->window, click_config_provider, menu);
     layer_add_child(root_layer, menu_layer_get_layer(menu->menu_layer));
     update_selected_highlight(menu, 0);
     menu_layer_set_selected_index(
@@ -227,18 +530,40 @@ static void menu_layer_setup(FrontableMenu* menu) {
 
 static void action_set_as_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
     FrontableMenu* menu = (FrontableMenu*)context;
-    messaging_set_as_front(menu->selected_frontable_hash);
+    messaging_set_as_front(menu->selected_frontable_id);
     window_pop_recursive(menu, true, true);
 }
 
 static void action_add_to_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
     FrontableMenu* menu = (FrontableMenu*)context;
-    messaging_add_to_front(menu->selected_frontable_hash);
+    messaging_add_to_front(menu->selected_frontable_id);
 }
 
 static void action_remove_from_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
     FrontableMenu* menu = (FrontableMenu*)context;
-    messaging_remove_from_front(menu->selected_frontable_hash);
+    messaging_remove_from_front(menu->selected_frontable_id);
+}
+
+static void action_front_selected(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    if (!send_front_list(menu->group_node.group->frontables, menu->checked, menu->checked_capacity)) return;
+
+    multi_select_end(menu);
+    window_pop_recursive(menu, true, true);
+}
+
+static void action_clear_selection(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    multi_select_end(menu);
+}
+
+static void action_front_group(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    FrontableMenu* menu = (FrontableMenu*)context;
+    if (menu->selected_group_node == NULL) return;
+
+    if (!send_front_list(menu->selected_group_node->group->frontables, NULL, 0)) return;
+
+    window_pop_recursive(menu, true, true);
 }
 
 static void action_menu_setup(FrontableMenu* menu) {
@@ -250,6 +575,13 @@ static void action_menu_setup(FrontableMenu* menu) {
     menu->fronting_action_level = action_menu_level_create(1);
     action_menu_level_add_action(menu->fronting_action_level, "Remove from front", action_remove_from_front, NULL);
 
+    menu->multi_select_action_level = action_menu_level_create(2);
+    action_menu_level_add_action(menu->multi_select_action_level, "Front selected", action_front_selected, NULL);
+    action_menu_level_add_action(menu->multi_select_action_level, "Clear selection", action_clear_selection, NULL);
+
+    menu->group_action_level = action_menu_level_create(1);
+    action_menu_level_add_action(menu->group_action_level, "Front whole group", action_front_group, NULL);
+
     menu->action_menu_config = (ActionMenuConfig) {
         .root_level = menu->non_fronting_action_level,
         .align = ActionMenuAlignTop,
@@ -266,8 +598,17 @@ static void action_menu_setup(FrontableMenu* menu) {
 static void window_load(Window* window) {
     FrontableMenu* menu = (FrontableMenu*)window_get_user_data(window);
 
+    menu->row_layouts = (RowLayout*)heap_stats_malloc(HEAP_TAG_MENUS, sizeof(RowLayout) * ROW_LAYOUT_CACHE_SIZE);
+    // without the cache every row is measured on the fly (see get_row_layout)
+    if (menu->row_layouts != NULL) {
+        memset(menu->row_layouts, 0, sizeof(RowLayout) * ROW_LAYOUT_CACHE_SIZE);
+    }
+
+    // layers and action levels live on the SDK's side of the heap
+    uint32_t mark = heap_stats_mark();
     menu_layer_setup(menu);
     action_menu_setup(menu);
+    heap_stats_account(HEAP_TAG_MENUS, mark);
 
     frontable_menu_update_colors(menu);
 
@@ -281,6 +622,10 @@ static void window_unload(Window* window) {
 
     menu->index_on_load = 0;
 
+    heap_stats_free(menu->row_layouts);
+    menu->row_layouts = NULL;
+
+    uint32_t mark = heap_stats_mark();
     menu_layer_destroy(menu->menu_layer);
     menu->menu_layer = NULL;
     layer_destroy(menu->status_bar_layer);
@@ -291,93 +636,79 @@ static void window_unload(Window* window) {
     menu->fronting_action_level = NULL;
     action_menu_hierarchy_destroy(menu->non_fronting_action_level, NULL, NULL);
     menu->non_fronting_action_level = NULL;
+    action_menu_hierarchy_destroy(menu->multi_select_action_level, NULL, NULL);
+    menu->multi_select_action_level = NULL;
+    action_menu_hierarchy_destroy(menu->group_action_level, NULL, NULL);
+    menu->group_action_level = NULL;
+    heap_stats_account(HEAP_TAG_MENUS, mark);
+
+    multi_select_end(menu);
+    menu->selected_group_node = NULL;
 
     if (menu->callbacks.window_unload != NULL) {
         menu->callbacks.window_unload(window);
     }
 }
 
-// ~~~ PUBLIC HELPERS ~~~
-
-void frontable_menu_draw_cell_custom(
-    FrontableMenu* menu,
-    GContext* ctx,
-    const Layer* cell_layer,
-    const char* main_text,
-    const char* bottom_left_text,
-    const char* bottom_right_text,
-    GColor tag_color
-) {
-    GRect bounds = layer_get_bounds(cell_layer);
+static void window_appear(Window* window) {
+    FrontableMenu* menu = (FrontableMenu*)window_get_user_data(window);
 
-    if (settings_get()->member_color_tag) {
-        // small color label on frontable
-        graphics_context_set_fill_color(ctx, tag_color);
-        GRect color_tag_bounds = bounds;
-#ifdef PBL_PLATFORM_EMERY
-        color_tag_bounds.size.w = 6;
-#else
-        color_tag_bounds.size.w = 3;
-#endif
-        graphics_fill_rect(ctx, color_tag_bounds, 0, GCornerNone);
+    if (menu->callbacks.window_appear != NULL) {
+        menu->callbacks.window_appear(window);
     }
+}
 
-    // set the new highlight color before draw
-    GColor highlight = frontable_menu_get_current_highlight_color(menu);
-    GColor text_color = gcolor_legible_over(highlight);
-    menu_layer_set_highlight_colors(
-        frontable_menu_get_menu_layer(menu),
-        highlight,
-        text_color
-    );
+static void window_disappear(Window* window) {
+    FrontableMenu* menu = (FrontableMenu*)window_get_user_data(window);
 
-    // ~~~ DRAW CODE ~~~
+    if (menu->callbacks.window_disappear != NULL) {
+        menu->callbacks.window_disappear(window);
+    }
+}
+
+// ~~~ PUBLIC HELPERS ~~~
 
-    // text parameters
-    static const char* NAME_FONT = FONT_KEY_GOTHIC_24_BOLD;
-    static const char* SUBTITLE_FONT = FONT_KEY_GOTHIC_18;
+// text parameters
+#define NAME_FONT FONT_KEY_GOTHIC_24_BOLD
+#define SUBTITLE_FONT FONT_KEY_GOTHIC_18
 #ifdef PBL_PLATFORM_EMERY
-    static const uint16_t PADDING = 10;
+#define CELL_PADDING 10
 #else
-    static const uint16_t PADDING = 5;
+#define CELL_PADDING 5
 #endif
-    static const uint16_t TEXT_SEPARATION = 1;
-
-    // text sizes ...
-
-    // limit text to our padded bounds
-    GRect padded_bounds = grect_inset(bounds, GEdgeInsets1(PADDING));
+#define TEXT_SEPARATION 1
+#define HORIZ_SEPARATION 3
+
+static void measure_row_subtitle(const char* text, GRect padded_bounds, GSize* size) {
+    *size = (GSize) {0, 0};
+    if (text != NULL) {
+        *size = graphics_text_layout_get_content_size(
+            text,
+            fonts_get_system_font(SUBTITLE_FONT),
+            padded_bounds,
+            GTextOverflowModeTrailingEllipsis,
+            GTextAlignmentCenter
+        );
+    }
+}
 
-    GSize main_size = graphics_text_layout_get_content_size(
+static void measure_row_main(RowLayout* layout, const char* main_text, GRect padded_bounds) {
+    layout->main_size = graphics_text_layout_get_content_size(
         main_text,
         fonts_get_system_font(NAME_FONT),
         padded_bounds,
         GTextOverflowModeTrailingEllipsis,
         PBL_IF_ROUND_ELSE(GTextAlignmentCenter, GTextAlignmentLeft)
     );
-    main_size.w = padded_bounds.size.w;
+    layout->main_size.w = padded_bounds.size.w;
+}
 
-    GSize bottom_right_size = {0, 0};
-    if (bottom_right_text != NULL) {
-        bottom_right_size = graphics_text_layout_get_content_size(
-            bottom_right_text,
-            fonts_get_system_font(SUBTITLE_FONT),
-            padded_bounds,
-            GTextOverflowModeTrailingEllipsis,
-            GTextAlignmentCenter
-        );
-    }
+// positions the boxes from already measured sizes, no text measuring here
+static void arrange_row_layout(RowLayout* layout, GRect padded_bounds, bool has_bl, bool has_br) {
+    GSize main_size = layout->main_size;
+    GSize bottom_left_size = layout->bottom_left_size;
+    GSize bottom_right_size = layout->bottom_right_size;
 
-    GSize bottom_left_size = {0, 0};
-    if (bottom_left_text != NULL) {
-        bottom_left_size = graphics_text_layout_get_content_size(
-            bottom_left_text,
-            fonts_get_system_font(SUBTITLE_FONT),
-            padded_bounds,
-            GTextOverflowModeTrailingEllipsis,
-            GTextAlignmentCenter
-        );
-    }
     if (bottom_left_size.w > padded_bounds.size.w - bottom_right_size.w) {
         bottom_left_size.w = padded_bounds.size.w - bottom_right_size.w;
     }
@@ -388,14 +719,14 @@ void frontable_menu_draw_cell_custom(
     bool space_for_subtitles =
         (bl_actual_height + main_actual_height + (TEXT_SEPARATION * 2) <= padded_bounds.size.h) &&
         (br_actual_height + main_actual_height + (TEXT_SEPARATION * 2) <= padded_bounds.size.h);
-    bool draw_bl = bottom_left_text != NULL && space_for_subtitles;
-    bool draw_br = bottom_right_text != NULL && space_for_subtitles;
+    layout->draw_bl = has_bl && space_for_subtitles;
+    layout->draw_br = has_br && space_for_subtitles;
 
     // create target drawing boxes
     GRect main_box = {{0, 0}, main_size};
     GRect bottom_left_box = {{0, 0}, bottom_left_size};
     GRect bottom_right_box = {{0, 0}, bottom_right_size};
-    if (!draw_bl && !draw_br) {
+    if (!layout->draw_bl && !layout->draw_br) {
         grect_align(&main_box, &padded_bounds, GAlignLeft, false);
         // center-align
         main_box.origin.y -= (main_size.h / 4);
@@ -419,14 +750,12 @@ void frontable_menu_draw_cell_custom(
     }
 
 #ifdef PBL_ROUND
-    static const uint16_t HORIZ_SEPARATION = 3;
-
     // align the subtitle boxes for round watches
-    if (draw_bl && !draw_br) {
+    if (layout->draw_bl && !layout->draw_br) {
         bottom_left_box.size.w = padded_bounds.size.w;
-    } else if (draw_br && !draw_bl) {
+    } else if (layout->draw_br && !layout->draw_bl) {
         bottom_right_box.size.w = padded_bounds.size.w;
-    } else if (draw_bl && draw_br) {
+    } else if (layout->draw_bl && layout->draw_br) {
         // align both boxes next to each other and centered in total
         int16_t total_width = bottom_left_box.size.w + bottom_right_box.size.w;
         int16_t combined_start_x = padded_bounds.origin.x +
@@ -441,22 +770,138 @@ void frontable_menu_draw_cell_custom(
     }
 #endif
 
+    layout->main_box = main_box;
+    layout->bottom_left_box = bottom_left_box;
+    layout->bottom_right_box = bottom_right_box;
+}
+
+// returns the cached layout for the row being drawn, re-measuring only
+//   what changed. main & bottom left text are tied to the row's frontable
+//   or group, bottom right text (fronting time) is compared by content
+static RowLayout* get_row_layout(
+    FrontableMenu* menu,
+    GRect bounds,
+    const char* main_text,
+    const char* bottom_left_text,
+    const char* bottom_right_text
+) {
+    static RowLayout scratch;
+
+    GRect padded_bounds = grect_inset(bounds, GEdgeInsets1(CELL_PADDING));
+
+    bool has_bl = bottom_left_text != NULL;
+    bool has_br = bottom_right_text != NULL;
+
+    RowLayout* layout = &scratch;
+    bool cached = false;
+    if (menu->row_layouts != NULL && menu->drawing_key != NULL) {
+        layout = &menu->row_layouts[menu->drawing_row % ROW_LAYOUT_CACHE_SIZE];
+        cached = layout->key == menu->drawing_key &&
+                 layout->generation == layout_generation &&
+                 layout->has_bl == has_bl &&
+                 gsize_equal(&layout->cell_size, &bounds.size);
+    }
+
+    bool br_changed = !cached ||
+                      layout->has_br != has_br ||
+                      (has_br && strcmp(layout->bottom_right_text, bottom_right_text) != 0);
+
+    if (cached && !br_changed) {
+        return layout;
+    }
+
+    if (!cached) {
+        measure_row_main(layout, main_text, padded_bounds);
+        measure_row_subtitle(bottom_left_text, padded_bounds, &layout->bottom_left_size);
+
+        layout->key = menu->drawing_key;
+        layout->generation = layout_generation;
+        layout->has_bl = has_bl;
+        layout->cell_size = bounds.size;
+    }
+
+    measure_row_subtitle(bottom_right_text, padded_bounds, &layout->bottom_right_size);
+    layout->has_br = has_br;
+    layout->bottom_right_text[0] = '\0';
+    if (has_br) {
+        string_safe_copy(layout->bottom_right_text, bottom_right_text, sizeof(layout->bottom_right_text));
+
+        // text too long to compare later, measure it again next time
+        if (strlen(bottom_right_text) >= sizeof(layout->bottom_right_text)) {
+            layout->key = NULL;
+        }
+    }
+
+    arrange_row_layout(layout, padded_bounds, has_bl, has_br);
+
+    return layout;
+}
+
+void frontable_menu_draw_cell_custom(
+    FrontableMenu* menu,
+    GContext* ctx,
+    const Layer* cell_layer,
+    const char* main_text,
+    const char* bottom_left_text,
+    const char* bottom_right_text,
+    GColor tag_color
+) {
+    GRect bounds = layer_get_bounds(cell_layer);
+
+    if (settings_get()->member_color_tag) {
+        // small color label on frontable
+        graphics_context_set_fill_color(ctx, tag_color);
+        GRect color_tag_bounds = bounds;
+#ifdef PBL_PLATFORM_EMERY
+        color_tag_bounds.size.w = 6;
+#else
+        color_tag_bounds.size.w = 3;
+#endif
+        graphics_fill_rect(ctx, color_tag_bounds, 0, GCornerNone);
+    }
+
+    // text makes room for the checkbox, the different cell size
+    //   alone is enough for cached layouts to get re-measured
+    GRect text_bounds = bounds;
+    if (menu->drawing_checkbox) {
+        text_bounds.size.w -= CHECKBOX_SIZE + CELL_PADDING;
+
+        GColor check_color = gcolor_legible_over(
+            menu_cell_layer_is_highlighted(cell_layer) ? menu->highlight_color : settings_get()->background_color
+        );
+        GRect box = GRect(
+            bounds.size.w - CELL_PADDING - CHECKBOX_SIZE,
+            (bounds.size.h - CHECKBOX_SIZE) / 2,
+            CHECKBOX_SIZE,
+            CHECKBOX_SIZE
+        );
+
+        graphics_context_set_stroke_color(ctx, check_color);
+        graphics_draw_rect(ctx, box);
+        if (menu->drawing_checked) {
+            graphics_context_set_fill_color(ctx, check_color);
+            graphics_fill_rect(ctx, grect_inset(box, GEdgeInsets1(2)), 0, GCornerNone);
+        }
+    }
+
+    RowLayout* layout = get_row_layout(menu, text_bounds, main_text, bottom_left_text, bottom_right_text);
+
     // text drawing itself
     graphics_draw_text(
         ctx,
         main_text,
         fonts_get_system_font(NAME_FONT),
-        main_box,
+        layout->main_box,
         GTextOverflowModeTrailingEllipsis,
         PBL_IF_ROUND_ELSE(GTextAlignmentCenter, GTextAlignmentLeft),
         NULL
     );
-    if (draw_bl) {
+    if (layout->draw_bl) {
         graphics_draw_text(
             ctx,
             bottom_left_text,
             fonts_get_system_font(SUBTITLE_FONT),
-            bottom_left_box,
+            layout->bottom_left_box,
             GTextOverflowModeTrailingEllipsis,
             // PBL_IF_ROUND_ELSE(
             //     draw_br ? GTextAlignmentRight : GTextAlignmentCenter,
@@ -467,12 +912,12 @@ void frontable_menu_draw_cell_custom(
             NULL
         );
     }
-    if (draw_br) {
+    if (layout->draw_br) {
         graphics_draw_text(
             ctx,
             bottom_right_text,
             fonts_get_system_font(SUBTITLE_FONT),
-            bottom_right_box,
+            layout->bottom_right_box,
             GTextOverflowModeTrailingEllipsis,
             // PBL_IF_ROUND_ELSE(
             //     draw_bl ? GTextAlignmentLeft : GTextAlignmentCenter,
@@ -485,6 +930,14 @@ void frontable_menu_draw_cell_custom(
     }
 }
 
+void frontable_menu_invalidate_layouts() {
+    layout_generation++;
+}
+
+void frontable_menu_set_offline(bool is_offline) {
+    offline = is_offline;
+}
+
 static void select_frontable(FrontableMenu* menu, Frontable* frontable) {
     // make accent be the color of the frontable, and change it
     //   if it matches the color of the background
@@ -507,7 +960,7 @@ static void select_frontable(FrontableMenu* menu, Frontable* frontable) {
     }
 
     // change selected frontable and open menu itself
-    menu->selected_frontable_hash = frontable->hash;
+    menu->selected_frontable_id = frontable->id;
     action_menu_open(&menu->action_menu_config);
 }
 
@@ -528,7 +981,7 @@ void frontable_menu_select(FrontableMenu* menu, MenuIndex* cell_index) {
         select_group(menu, node);
     } else {
         uint16_t i = cell_index->row - menu->group_node.num_children;
-        Frontable* f = menu->group_node.group->frontables->frontables[i];
+        Frontable* f = frontable_list_get_sorted(menu->group_node.group->frontables, i);
         select_frontable(menu, f);
     }
 }
@@ -537,11 +990,6 @@ void frontable_menu_update_colors(FrontableMenu* menu) {
     ClaySettings* settings = settings_get();
 
     if (menu->menu_layer != NULL) {
-        menu_layer_set_highlight_colors(
-            menu->menu_layer,
-            settings_get_global_accent(),
-            gcolor_legible_over(settings_get_global_accent())
-        );
         menu_layer_set_normal_colors(
             menu->menu_layer,
             settings->background_color,
@@ -550,6 +998,7 @@ void frontable_menu_update_colors(FrontableMenu* menu) {
 
         uint16_t current_index = menu_layer_get_selected_index(menu->menu_layer).row;
         update_selected_highlight(menu, current_index);
+        apply_highlight_colors(menu);
     }
 
     if (menu->status_bar_text != NULL) {
@@ -604,17 +1053,21 @@ static void add_child_group(GroupTreeNode* parent, GroupTreeNode* child) {
 
 FrontableMenu* frontable_menu_create(MemberMenuCallbacks callbacks, Group* group) {
     // create window and set up handlers
+    uint32_t mark = heap_stats_mark();
     Window* window = window_create();
+    heap_stats_account(HEAP_TAG_MENUS, mark);
     window_set_window_handlers(
         window,
         (WindowHandlers) {
             .load = window_load,
-            .unload = window_unload
+            .unload = window_unload,
+            .appear = window_appear,
+            .disappear = window_disappear
         }
     );
 
     // malloc new menu and assign values
-    FrontableMenu* menu = (FrontableMenu*)malloc(sizeof(FrontableMenu));
+    FrontableMenu* menu = (FrontableMenu*)heap_stats_malloc(HEAP_TAG_MENUS, sizeof(FrontableMenu));
     *menu = (FrontableMenu) {
         .window = window,
         .callbacks = callbacks,
@@ -634,8 +1087,15 @@ FrontableMenu* frontable_menu_create(MemberMenuCallbacks callbacks, Group* group
 }
 
 void frontable_menu_destroy(FrontableMenu* menu) {
+    uint32_t mark = heap_stats_mark();
     window_destroy(menu->window);
-    free(menu);
+    heap_stats_account(HEAP_TAG_MENUS, mark);
+
+    if (menu->checked != NULL) {
+        heap_stats_free(menu->checked);
+    }
+
+    heap_stats_free(menu);
 }
 
 void frontable_menu_window_push(FrontableMenu* menu, bool recursive, bool animated) {
@@ -21,9 +21,13 @@ typedef struct {
     FrontableMenuDrawRowCallback draw_row;
     WindowHandler window_load;
     WindowHandler window_unload;
+    WindowHandler window_appear;
+    WindowHandler window_disappear;
 } MemberMenuCallbacks;
 
 void frontable_menu_draw_cell_custom(FrontableMenu* menu, GContext* ctx, const Layer* cell_layer, const char* main_text, const char* bottom_left_text, const char* bottom_right_text, GColor tag_color);
+void frontable_menu_invalidate_layouts();
+void frontable_menu_set_offline(bool offline);
 void frontable_menu_select(FrontableMenu* menu, MenuIndex* cell_index);
 void frontable_menu_update_colors(FrontableMenu* menu);
 FrontableMenu* frontable_menu_create(MemberMenuCallbacks callbacks, Group* group);
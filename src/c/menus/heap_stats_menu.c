@@ -0,0 +1,193 @@
+#include "heap_stats_menu.h"
+#include "../data/config.h"
+#include "../messaging/messaging.h"
+#include "../tools/heap_stats.h"
+#include <pebble.h>
+
+#if HEAP_STATS_ENABLED
+
+// free heap first, then one row per tag, then sending
+#define NUM_ROWS (HEAP_TAG_COUNT + 2)
+#define ROW_SEND (NUM_ROWS - 1)
+
+static Window* window = NULL;
+static SimpleMenuLayer* simple_menu_layer = NULL;
+static SimpleMenuItem items[NUM_ROWS];
+static SimpleMenuSection sections[1];
+static TextLayer* status_bar_text = NULL;
+static Layer* status_bar_layer = NULL;
+static char subtitles[NUM_ROWS - 1][32];
+
+static void status_bar_update_proc(Layer* layer, GContext* ctx) {
+    graphics_context_set_fill_color(ctx, settings_get()->background_color);
+    graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+}
+
+static void update_subtitles() {
+    snprintf(
+        subtitles[0],
+        sizeof(subtitles[0]),
+        "%lu now, %lu min",
+        (uint32_t)heap_bytes_free(),
+        heap_stats_get_min_free()
+    );
+
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+        const HeapTagStats* stats = heap_stats_get(i);
+        snprintf(
+            subtitles[i + 1],
+            sizeof(subtitles[i + 1]),
+            "%ld/%ld b, %lu allocs",
+            stats->live_bytes,
+            stats->peak_bytes,
+            stats->num_allocs
+        );
+    }
+
+    if (simple_menu_layer != NULL) {
+        layer_mark_dirty(simple_menu_layer_get_layer(simple_menu_layer));
+    }
+}
+
+static void select(int index, void* context) {
+    if (index == ROW_SEND) {
+        heap_stats_log();
+        messaging_send_heap_stats();
+    }
+
+    // numbers move while browsing, any row refreshes them
+    update_subtitles();
+}
+
+static void window_load() {
+    Layer* root_layer = window_get_root_layer(window);
+
+    items[0] = (SimpleMenuItem) {
+        .title = "Free Heap",
+        .subtitle = subtitles[0],
+        .icon = NULL,
+        .callback = select
+    };
+
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+        items[i + 1] = (SimpleMenuItem) {
+            .title = heap_stats_get_tag_name(i),
+            .subtitle = subtitles[i + 1],
+            .icon = NULL,
+            .callback = select
+        };
+    }
+
+    items[ROW_SEND] = (SimpleMenuItem) {
+        .title = "Send to Phone",
+        .subtitle = "Shows in the phone log",
+        .icon = NULL,
+        .callback = select
+    };
+
+    sections[0] = (SimpleMenuSection) {
+        .num_items = NUM_ROWS,
+        .items = items
+    };
+
+    update_subtitles();
+
+    GRect menu_bounds = layer_get_bounds(root_layer);
+
+#if !defined(PBL_ROUND)
+    menu_bounds.origin.y += STATUS_BAR_LAYER_HEIGHT;
+    menu_bounds.size.h -= STATUS_BAR_LAYER_HEIGHT;
+#endif
+
+    simple_menu_layer = simple_menu_layer_create(
+        menu_bounds,
+        window,
+        sections,
+        1,
+        NULL
+    );
+
+    menu_layer_set_highlight_colors(
+        simple_menu_layer_get_menu_layer(simple_menu_layer),
+        settings_get_global_accent(),
+        gcolor_legible_over(settings_get_global_accent())
+    );
+    menu_layer_set_normal_colors(
+        simple_menu_layer_get_menu_layer(simple_menu_layer),
+        settings_get()->background_color,
+        gcolor_legible_over(settings_get()->background_color)
+    );
+
+    layer_add_child(root_layer, simple_menu_layer_get_layer(simple_menu_layer));
+
+    // ~~~ create status bar layers ~~~
+
+    GRect status_bar_bounds = layer_get_bounds(root_layer);
+    status_bar_bounds.size.h = STATUS_BAR_LAYER_HEIGHT;
+
+    GRect status_bar_text_bounds = status_bar_bounds;
+    status_bar_text_bounds.size.h = 14;
+    grect_align(&status_bar_text_bounds, &status_bar_bounds, GAlignCenter, false);
+
+#if !defined(PBL_ROUND)
+    status_bar_text_bounds.origin.y -= 3;
+#endif
+
+    status_bar_layer = layer_create(status_bar_bounds);
+    layer_set_update_proc(status_bar_layer, status_bar_update_proc);
+
+    status_bar_text = text_layer_create(status_bar_text_bounds);
+    text_layer_set_font(status_bar_text, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    text_layer_set_text_alignment(status_bar_text, GTextAlignmentCenter);
+    text_layer_set_background_color(status_bar_text, settings_get()->background_color);
+    text_layer_set_text_color(status_bar_text, gcolor_legible_over(settings_get()->background_color));
+    text_layer_set_text(status_bar_text, "Heap Stats");
+
+    layer_add_child(status_bar_layer, text_layer_get_layer(status_bar_text));
+    layer_add_child(root_layer, status_bar_layer);
+
+    window_set_background_color(window, settings_get()->background_color);
+}
+
+static void window_appear() {
+    update_subtitles();
+}
+
+static void window_unload() {
+    simple_menu_layer_destroy(simple_menu_layer);
+    simple_menu_layer = NULL;
+    text_layer_destroy(status_bar_text);
+    status_bar_text = NULL;
+    layer_destroy(status_bar_layer);
+    status_bar_layer = NULL;
+}
+
+void heap_stats_menu_push() {
+    if (window == NULL) {
+        window = window_create();
+        window_set_window_handlers(
+            window,
+            (WindowHandlers) {
+                .load = window_load,
+                .appear = window_appear,
+                .unload = window_unload
+            }
+        );
+    }
+
+    window_stack_push(window, true);
+}
+
+void heap_stats_menu_deinit() {
+    if (window != NULL) {
+        window_destroy(window);
+        window = NULL;
+    }
+}
+
+#else
+
+void heap_stats_menu_push() { }
+void heap_stats_menu_deinit() { }
+
+#endif
@@ -0,0 +1,4 @@
+#pragma once
+
+void heap_stats_menu_push();
+void heap_stats_menu_deinit();
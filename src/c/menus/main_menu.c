@@ -1,7 +1,11 @@
 #include "main_menu.h"
 #include "../data/config.h"
+#include "../data/frecency.h"
 #include "../data/frontable_cache.h"
 #include "../frontables/frontable_list.h"
+#include "../messaging/messaging.h"
+#include "../tools/heap_stats.h"
+#include "../tools/trace.h"
 #include "current_fronters_menu.h"
 #include "custom_fronts_menu.h"
 #include "members_menu.h"
@@ -10,15 +14,36 @@
 static Window* window = NULL;
 static SimpleMenuLayer* simple_menu_layer = NULL;
 static SimpleMenuItem items[4];
-static SimpleMenuSection sections[1];
+static SimpleMenuSection sections[2];
+static uint8_t num_sections = 1;
+static uint8_t num_items = 0;
 static TextLayer* status_bar_text_layer = NULL;
 static Layer* status_bar_layer = NULL;
 static bool members_loaded = false;
 static bool custom_fronts_loaded = false;
 static bool current_fronters_loaded = false;
 static bool custom_fronts_hidden = true;
+static bool fetching = false;
+static bool offline = false;
 static char status_bar_text[64] = "Plurble";
 
+// ~~~ likely fronters ~~~
+
+// kept short so the main items still fit on screen
+#define LIKELY_MAX_ITEMS 3
+
+// names are copied so items never point at frontables a sync freed
+static SimpleMenuItem likely_items[LIKELY_MAX_ITEMS];
+static char likely_names[LIKELY_MAX_ITEMS][FRONTABLE_NAME_LENGTH];
+static char likely_pronouns[LIKELY_MAX_ITEMS][FRONTABLE_PRONOUNS_LENGTH];
+static uint16_t likely_ids[LIKELY_MAX_ITEMS];
+static uint8_t num_likely = 0;
+static uint16_t selected_likely_id = FRONTABLE_ID_NONE;
+
+static ActionMenuLevel* non_fronting_action_level = NULL;
+static ActionMenuLevel* fronting_action_level = NULL;
+static ActionMenuConfig action_menu_config;
+
 static void select(int index, void* context) {
     switch (index) {
         case 0:
@@ -53,7 +78,106 @@ static void select(int index, void* context) {
     }
 }
 
+static void action_set_as_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    messaging_set_as_front(selected_likely_id);
+}
+
+static void action_add_to_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    messaging_add_to_front(selected_likely_id);
+}
+
+static void action_remove_from_front(ActionMenu* action_menu, const ActionMenuItem* action, void* context) {
+    messaging_remove_from_front(selected_likely_id);
+}
+
+static void action_menu_setup() {
+    uint32_t mark = heap_stats_mark();
+
+    non_fronting_action_level = action_menu_level_create(2);
+    action_menu_level_add_action(non_fronting_action_level, "Set as front", action_set_as_front, NULL);
+    action_menu_level_add_action(non_fronting_action_level, "Add to front", action_add_to_front, NULL);
+
+    fronting_action_level = action_menu_level_create(1);
+    action_menu_level_add_action(fronting_action_level, "Remove from front", action_remove_from_front, NULL);
+
+    action_menu_config = (ActionMenuConfig) {
+        .root_level = non_fronting_action_level,
+        .align = ActionMenuAlignTop,
+        .context = NULL
+    };
+
+    heap_stats_account(HEAP_TAG_MENUS, mark);
+}
+
+static void select_likely(int index, void* context) {
+    Frontable* frontable = cache_get_frontable(likely_ids[index]);
+    if (frontable == NULL) return;
+
+    // same coloring as the action menu in frontable menus
+    GColor action_menu_accent = frontable_get_color(frontable);
+    if ((action_menu_accent.argb & 0b00111111) == 0) {
+        action_menu_accent = GColorDarkGray;
+    }
+    action_menu_config.colors.background = action_menu_accent;
+    action_menu_config.colors.foreground = gcolor_legible_over(action_menu_accent);
+
+    if (frontable_get_is_fronting(frontable)) {
+        action_menu_config.root_level = fronting_action_level;
+    } else {
+        action_menu_config.root_level = non_fronting_action_level;
+    }
+
+    selected_likely_id = frontable->id;
+    action_menu_open(&action_menu_config);
+}
+
+// likely section only shows up when there's something in it
+static void build_sections() {
+    num_sections = 0;
+
+    if (num_likely > 0) {
+        sections[num_sections++] = (SimpleMenuSection) {
+            .title = "Likely",
+            .items = likely_items,
+            .num_items = num_likely
+        };
+    }
+
+    sections[num_sections++] = (SimpleMenuSection) {
+        .items = items,
+        .num_items = num_items
+    };
+}
+
+static void create_simple_menu_layer() {
+    Layer* root_layer = window_get_root_layer(window);
+    GRect menu_bounds = layer_get_bounds(root_layer);
+
+#if !defined(PBL_ROUND)
+    // only offset if not round, that way round watches
+    //   keep the highlighted option centered !
+    menu_bounds.origin.y += STATUS_BAR_LAYER_HEIGHT;
+    menu_bounds.size.h -= STATUS_BAR_LAYER_HEIGHT;
+#endif
+
+    simple_menu_layer = simple_menu_layer_create(
+        menu_bounds,
+        window,
+        sections,
+        num_sections,
+        NULL
+    );
+
+    if (status_bar_layer != NULL) {
+        layer_insert_below_sibling(simple_menu_layer_get_layer(simple_menu_layer), status_bar_layer);
+    } else {
+        layer_add_child(root_layer, simple_menu_layer_get_layer(simple_menu_layer));
+    }
+}
+
 static void status_bar_update_proc(Layer* layer, GContext* ctx) {
+    trace_first_draw();
+
     graphics_context_set_fill_color(ctx, settings_get()->background_color);
     graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
 }
@@ -63,15 +187,15 @@ static void window_load() {
 
     // ~~~ create menu items ~~~
 
-    uint32_t item_count = 0;
+    num_items = 0;
 
-    items[item_count++] = (SimpleMenuItem) {
+    items[num_items++] = (SimpleMenuItem) {
         .title = "Fronters",
         .icon = NULL,
         .callback = select
     };
 
-    items[item_count++] = (SimpleMenuItem) {
+    items[num_items++] = (SimpleMenuItem) {
         .title = "Members",
         .subtitle = members_loaded ? NULL : "loading members...",
         .icon = NULL,
@@ -79,7 +203,7 @@ static void window_load() {
     };
 
     if (!custom_fronts_hidden) {
-        items[item_count++] = (SimpleMenuItem) {
+        items[num_items++] = (SimpleMenuItem) {
             .title = "Custom Fronts",
             .subtitle = custom_fronts_loaded ? NULL : "loading custom fronts...",
             .icon = NULL,
@@ -87,36 +211,19 @@ static void window_load() {
         };
     }
 
-    items[item_count++] = (SimpleMenuItem) {
+    items[num_items++] = (SimpleMenuItem) {
         .title = "Settings",
         .subtitle = NULL,
         .icon = NULL,
         .callback = select
     };
 
-    sections[0] = (SimpleMenuSection) {
-        .items = items,
-        .num_items = item_count,
-    };
-
-    GRect menu_bounds = layer_get_bounds(root_layer);
-
-#if !defined(PBL_ROUND)
-    // only offset if not round, that way round watches
-    //   keep the highlighted option centered !
-    menu_bounds.origin.y += STATUS_BAR_LAYER_HEIGHT;
-    menu_bounds.size.h -= STATUS_BAR_LAYER_HEIGHT;
-#endif
+    build_sections();
+    create_simple_menu_layer();
 
-    simple_menu_layer = simple_menu_layer_create(
-        menu_bounds,
-        window,
-        sections,
-        1,
-        NULL
-    );
-
-    layer_add_child(root_layer, simple_menu_layer_get_layer(simple_menu_layer));
+    if (non_fronting_action_level == NULL) {
+        action_menu_setup();
+    }
 
     // ~~~ create status bar layers ~~~
 
@@ -147,6 +254,11 @@ static void window_load() {
     main_menu_update_fronters_subtitle();
 }
 
+static void window_appear() {
+    // fronting from a submenu bumps scores, pick that up on the way back
+    main_menu_refresh_likely();
+}
+
 static void window_unload() {
     simple_menu_layer_destroy(simple_menu_layer);
     simple_menu_layer = NULL;
@@ -163,6 +275,7 @@ void main_menu_push() {
             window,
             (WindowHandlers) {
                 .load = window_load,
+                .appear = window_appear,
                 .unload = window_unload
             }
         );
@@ -202,6 +315,51 @@ void main_menu_deinit() {
         window_destroy(window);
         window = NULL;
     }
+
+    if (non_fronting_action_level != NULL) {
+        uint32_t mark = heap_stats_mark();
+        action_menu_hierarchy_destroy(non_fronting_action_level, NULL, NULL);
+        non_fronting_action_level = NULL;
+        action_menu_hierarchy_destroy(fronting_action_level, NULL, NULL);
+        fronting_action_level = NULL;
+        heap_stats_account(HEAP_TAG_MENUS, mark);
+    }
+}
+
+void main_menu_refresh_likely() {
+    Frontable* top[LIKELY_MAX_ITEMS];
+    uint8_t count = frecency_get_top(top, LIKELY_MAX_ITEMS);
+
+    bool order_changed = count != num_likely;
+    for (uint8_t i = 0; i < count; i++) {
+        if (likely_ids[i] != top[i]->id) {
+            order_changed = true;
+        }
+
+        likely_ids[i] = top[i]->id;
+        strncpy(likely_names[i], top[i]->name, FRONTABLE_NAME_LENGTH);
+        strncpy(likely_pronouns[i], top[i]->pronouns, FRONTABLE_PRONOUNS_LENGTH);
+        likely_items[i] = (SimpleMenuItem) {
+            .title = likely_names[i],
+            .subtitle = likely_pronouns[i][0] != '\0' ? likely_pronouns[i] : NULL,
+            .icon = NULL,
+            .callback = select_likely
+        };
+    }
+    num_likely = count;
+
+    if (simple_menu_layer == NULL) return;
+
+    if (order_changed) {
+        // simple menu layers can't change their sections after
+        //   creation, so swap in a new one with the new order
+        simple_menu_layer_destroy(simple_menu_layer);
+        build_sections();
+        create_simple_menu_layer();
+        main_menu_update_colors();
+    } else {
+        layer_mark_dirty(simple_menu_layer_get_layer(simple_menu_layer));
+    }
 }
 
 void main_menu_mark_fronters_loaded() {
@@ -281,8 +439,10 @@ void main_menu_mark_custom_fronts_loaded() {
     custom_fronts_loaded = true;
 }
 
-void main_menu_update_fetch_status(bool fetching) {
-    if (fetching) {
+static void update_status_bar_text() {
+    if (offline) {
+        strncpy(status_bar_text, "Offline", sizeof(status_bar_text));
+    } else if (fetching) {
         strncpy(status_bar_text, "Loading...", sizeof(status_bar_text));
     } else {
         strncpy(status_bar_text, "Plurble", sizeof(status_bar_text));
@@ -292,3 +452,13 @@ void main_menu_update_fetch_status(bool fetching) {
         layer_mark_dirty(text_layer_get_layer(status_bar_text_layer));
     }
 }
+
+void main_menu_update_fetch_status(bool is_fetching) {
+    fetching = is_fetching;
+    update_status_bar_text();
+}
+
+void main_menu_set_offline(bool is_offline) {
+    offline = is_offline;
+    update_status_bar_text();
+}
@@ -10,3 +10,5 @@ void main_menu_mark_custom_fronts_loaded();
 void main_menu_mark_fronters_loaded();
 void main_menu_update_fronters_subtitle();
 void main_menu_update_fetch_status(bool fetching);
+void main_menu_set_offline(bool offline);
+void main_menu_refresh_likely();
@@ -1,6 +1,9 @@
 #include "members_menu.h"
 #include "../data/frontable_cache.h"
+#include "../data/memory_governor.h"
+#include "../tools/heap_stats.h"
 #include "../tools/string_tools.h"
+#include "../tools/trace.h"
 #include "frontable_menu.h"
 #include <pebble.h>
 
@@ -29,7 +32,7 @@ static void draw_cell(FrontableMenu* menu, GContext* ctx, const Layer* cell_laye
     bool show_pronouns = settings_get()->show_pronouns;
 
     char* name = NULL;
-    char* pronouns = NULL;
+    const char* pronouns = NULL;
     GColor color = GColorBlack;
 
     if (selected_group != NULL) {
@@ -54,17 +57,21 @@ static void draw_cell(FrontableMenu* menu, GContext* ctx, const Layer* cell_laye
     );
 }
 
+// groupless members only get their own list when groups are shown,
+//   and when there's memory to spare for it
+static bool uses_hidden_root() {
+    return settings_get()->hide_members_in_root &&
+           settings_get()->show_groups &&
+           !memory_governor_is_shedding(MEMORY_LEVEL_NO_HIDDEN_ROOT);
+}
+
 static void root_init() {
     hidden_root_list = frontable_list_create();
 
     root_group.color = settings_get()->background_color;
     strcpy(root_group.name, "Members");
     root_group.parent = NULL;
-    if (settings_get()->hide_members_in_root && settings_get()->show_groups) {
-        root_group.frontables = hidden_root_list;
-    } else {
-        root_group.frontables = cache_get_members();
-    }
+    root_group.frontables = uses_hidden_root() ? hidden_root_list : cache_get_members();
 
     MemberMenuCallbacks callbacks = {
         .draw_row = draw_cell,
@@ -87,6 +94,13 @@ static void groups_init() {
     GroupCollection* group_collection = cache_get_groups();
     num_groups = group_collection->num_stored;
 
+    // every group menu is a window and menu layer, first to go after pronouns
+    if (memory_governor_is_shedding(MEMORY_LEVEL_NO_GROUPS)) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Low on memory, not creating group menus!");
+        num_groups = 0;
+        return;
+    }
+
     MemberMenuCallbacks callbacks = {
         .draw_row = draw_cell,
         .select = select,
@@ -95,7 +109,7 @@ static void groups_init() {
     };
 
     // create menus with null parent pointers
-    menus = (FrontableMenu**)malloc(sizeof(FrontableMenu*) * num_groups);
+    menus = (FrontableMenu**)heap_stats_malloc(HEAP_TAG_MENUS, sizeof(FrontableMenu*) * num_groups);
     for (uint16_t i = 0; i < num_groups; i++) {
         Group* group = group_collection->groups[i];
         if (group->parent == NULL) group->parent = &root_group;
@@ -127,7 +141,7 @@ static void groups_deinit() {
             frontable_menu_destroy(menus[i]);
         }
 
-        free(menus);
+        heap_stats_free(menus);
         menus = NULL;
     }
 
@@ -183,6 +197,7 @@ void members_menu_update_colors() {
 
 void members_menu_remove_groups() {
     APP_LOG(APP_LOG_LEVEL_INFO, "Removing members menu groups...");
+    trace_record(TRACE_EVENT_MENUS_TEARDOWN_START, num_groups);
 
     strncpy(prev_group_name, "", sizeof(prev_group_name));
     prev_selected_index = 0;
@@ -228,11 +243,13 @@ void members_menu_remove_groups() {
 
     groups_initialized = false;
 
+    trace_record(TRACE_EVENT_MENUS_TEARDOWN_END, 0);
     APP_LOG(APP_LOG_LEVEL_INFO, "Groups removed!");
 }
 
 void members_menu_create_groups() {
     APP_LOG(APP_LOG_LEVEL_INFO, "Creating members menu groups...");
+    trace_record(TRACE_EVENT_MENUS_REBUILD_START, 0);
 
     groups_init();
 
@@ -240,11 +257,7 @@ void members_menu_create_groups() {
         frontable_menu_clear_children(root_menu);
     }
 
-    if (settings_get()->hide_members_in_root && settings_get()->show_groups) {
-        root_group.frontables = hidden_root_list;
-    } else {
-        root_group.frontables = cache_get_members();
-    }
+    root_group.frontables = uses_hidden_root() ? hidden_root_list : cache_get_members();
 
     // find group again and push it back to the stack (if it exists)
     FrontableMenu* menu_to_restore = NULL;
@@ -273,6 +286,7 @@ void members_menu_create_groups() {
 
     groups_initialized = true;
 
+    trace_record(TRACE_EVENT_MENUS_REBUILD_END, num_groups);
     APP_LOG(APP_LOG_LEVEL_INFO, "Groups created!");
 }
 
@@ -283,6 +297,11 @@ void members_menu_refresh_groupless_members() {
         frontable_list_clear(hidden_root_list);
     }
 
+    if (!uses_hidden_root()) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "Groupless members aren't shown on their own, skipping search!");
+        return;
+    }
+
     GroupCollection* group_collection = cache_get_groups();
     FrontableList* members = cache_get_members();
 
@@ -305,5 +324,9 @@ void members_menu_refresh_groupless_members() {
         }
     }
 
+    if (hidden_root_list != NULL) {
+        cache_sort_list(hidden_root_list);
+    }
+
     APP_LOG(APP_LOG_LEVEL_INFO, "Groupless member search finished!");
 }
@@ -1,13 +1,23 @@
 #include "settings_menu.h"
 #include "../data/config.h"
 #include "../data/frontable_cache.h"
+#include "../data/persistence.h"
+#include "../menus/frontable_menu.h"
+#include "../menus/heap_stats_menu.h"
 #include "../menus/members_menu.h"
 #include "../messaging/messaging.h"
+#include "../tools/heap_stats.h"
+#include "../tools/trace.h"
 #include <pebble.h>
 
 static Window* window = NULL;
 static SimpleMenuLayer* simple_menu_layer = NULL;
-static SimpleMenuItem items[3];
+// debug builds get their rows after the regular ones
+#define ITEM_HEAP_STATS 4
+#define ITEM_DUMP_TRACE (ITEM_HEAP_STATS + HEAP_STATS_ENABLED)
+#define NUM_ITEMS (ITEM_DUMP_TRACE + TRACE_ENABLED)
+
+static SimpleMenuItem items[NUM_ITEMS];
 static SimpleMenuSection sections[1];
 static TextLayer* status_bar_text = NULL;
 static Layer* status_bar_layer = NULL;
@@ -22,6 +32,17 @@ static void status_bar_update_proc(Layer* layer, GContext* ctx) {
     graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
 }
 
+static const char* SORT_ORDER_NAMES[SORT_ORDER_COUNT] = {
+    "Name",
+    "Fronting first",
+    "Color"
+};
+
+static const char* get_sort_order_name() {
+    uint8_t order = settings_get()->sort_order;
+    return order < SORT_ORDER_COUNT ? SORT_ORDER_NAMES[order] : SORT_ORDER_NAMES[SORT_ORDER_NAME];
+}
+
 static void reset_fetch_name_callback(void* data) {
     strncpy(fetch_subtitle, "Re-fetch from API...", sizeof(fetch_subtitle));
     can_fetch_members = true;
@@ -54,8 +75,8 @@ void settings_menu_confirm_frontable_fetch() {
 
 static void reset_cache_confirm(void* data) {
     confirm_clear_cache = false;
-    items[2].subtitle = "Will reset app...";
-    items[2].title = "Clear Cache";
+    items[3].subtitle = "Will reset app...";
+    items[3].title = "Clear Cache";
 
     if (confirm_clear_cache_timer != NULL) {
         app_timer_cancel(confirm_clear_cache_timer);
@@ -71,6 +92,7 @@ static void select(int index, void* context) {
     switch (index) {
         case 0:
             settings_get()->show_groups = !settings_get()->show_groups;
+            persistence_mark_settings_dirty();
 
             items[0].subtitle = settings_get()->show_groups ? "True" : "False";
             if (simple_menu_layer != NULL) {
@@ -83,6 +105,18 @@ static void select(int index, void* context) {
             break;
 
         case 1:
+            // orders are already computed, this only re-points the lists
+            settings_get()->sort_order = (settings_get()->sort_order + 1) % SORT_ORDER_COUNT;
+            persistence_mark_settings_dirty();
+
+            items[1].subtitle = get_sort_order_name();
+
+            cache_apply_sort_order();
+            members_menu_refresh_groupless_members();
+            frontable_menu_invalidate_layouts();
+            break;
+
+        case 2:
             if (can_fetch_members) {
                 messaging_fetch_data();
                 strncpy(fetch_subtitle, "Fetching...", sizeof(fetch_subtitle));
@@ -91,18 +125,30 @@ static void select(int index, void* context) {
             }
             break;
 
-        case 2:
+        case 3:
             if (!confirm_clear_cache) {
-                items[2].subtitle = "Click to confirm";
-                items[2].title = "U SURE?";
+                items[3].subtitle = "Click to confirm";
+                items[3].title = "U SURE?";
                 confirm_clear_cache = true;
                 app_timer_register(2000, reset_cache_confirm, NULL);
             } else {
                 reset_cache_confirm(NULL);
-                cache_persist_delete();
+                persistence_discard_cache();
                 messaging_clear_cache();
             }
             break;
+
+#if HEAP_STATS_ENABLED
+        case ITEM_HEAP_STATS:
+            heap_stats_menu_push();
+            break;
+#endif
+
+#if TRACE_ENABLED
+        case ITEM_DUMP_TRACE:
+            messaging_send_trace();
+            break;
+#endif
     }
 
     layer_mark_dirty(simple_menu_layer_get_layer(simple_menu_layer));
@@ -119,21 +165,46 @@ static void window_load() {
     };
 
     items[1] = (SimpleMenuItem) {
+        .title = "Sort By",
+        .subtitle = get_sort_order_name(),
+        .icon = NULL,
+        .callback = select
+    };
+
+    items[2] = (SimpleMenuItem) {
         .title = "Refresh Data",
         .subtitle = fetch_subtitle,
         .icon = NULL,
         .callback = select,
     };
 
-    items[2] = (SimpleMenuItem) {
+    items[3] = (SimpleMenuItem) {
         .title = "Clear Cache",
         .subtitle = "Will reset app...",
         .icon = NULL,
         .callback = select,
     };
 
+#if HEAP_STATS_ENABLED
+    items[ITEM_HEAP_STATS] = (SimpleMenuItem) {
+        .title = "Heap Stats",
+        .subtitle = "Debug",
+        .icon = NULL,
+        .callback = select,
+    };
+#endif
+
+#if TRACE_ENABLED
+    items[ITEM_DUMP_TRACE] = (SimpleMenuItem) {
+        .title = "Dump Trace",
+        .subtitle = "Shows in the phone log",
+        .icon = NULL,
+        .callback = select,
+    };
+#endif
+
     sections[0] = (SimpleMenuSection) {
-        .num_items = 3,
+        .num_items = NUM_ITEMS,
         .items = items
     };
 
@@ -1,17 +1,32 @@
 #include "messaging.h"
 #include "../data/config.h"
+#include "../data/frecency.h"
 #include "../data/frontable_cache.h"
+#include "../data/memory_governor.h"
+#include "../data/persistence.h"
 #include "../menus/current_fronters_menu.h"
 #include "../menus/error_menu.h"
+#include "../menus/frontable_menu.h"
 #include "../menus/main_menu.h"
 #include "../menus/members_menu.h"
 #include "../menus/settings_menu.h"
 #include "../menus/setup_prompt_menu.h"
+#include "../tools/heap_stats.h"
 #include "../tools/string_tools.h"
+#include "../tools/trace.h"
 #include <pebble.h>
 
 #define DELIMETER ';'
 
+// most ids one front list request can carry, the outbox is sized for it
+#define FRONT_LIST_MAX_COUNT 128
+
+// most events one trace dump carries, 8 bytes an event
+#define TRACE_DUMP_MAX_ENTRIES 48
+
+// heap stats go out as u32s: free now, lowest free, then 4 per tag
+#define HEAP_STATS_VALUE_COUNT (2 + HEAP_TAG_COUNT * 4)
+
 // make sure these defines match the enum type in types.ts
 #define ERROR_CODE_API_KEY_INVALID 1
 
@@ -19,30 +34,228 @@
 //!   include paths folder to get rid of the warnings about
 //!   MESSAGE_KEY_WhateverKeys being undefined !!!!
 
+// every tuple the inbox understands is routed into one of these slots
+//   during a single pass over the dictionary, decoders then read
+//   the slots directly instead of searching the dictionary again
+typedef enum {
+    INBOX_SLOT_ACCENT_COLOR,
+    INBOX_SLOT_BACKGROUND_COLOR,
+    INBOX_SLOT_COMPACT_MEMBER_LIST,
+    INBOX_SLOT_MEMBER_COLOR_HIGHLIGHT,
+    INBOX_SLOT_MEMBER_COLOR_TAG,
+    INBOX_SLOT_GLOBAL_FRONTER_ACCENT,
+    INBOX_SLOT_GROUP_TITLE_ACCENT,
+    INBOX_SLOT_HIDE_MEMBERS_IN_ROOT,
+    INBOX_SLOT_SHOW_PRONOUNS,
+    INBOX_SLOT_SHOW_TIME_FRONTING,
+    INBOX_SLOT_CUSTOM_FRONT_TEXT,
+
+    INBOX_SLOT_NUM_CURRENT_FRONTERS,
+    INBOX_SLOT_NUM_CURRENT_FRONTERS_IN_BATCH,
+    INBOX_SLOT_CURRENT_FRONTER,
+    INBOX_SLOT_CURRENT_FRONT_START_TIME,
+
+    INBOX_SLOT_NUM_TOTAL_FRONTABLES,
+    INBOX_SLOT_NUM_FRONTABLES_IN_BATCH,
+    INBOX_SLOT_FRONTABLE_ID,
+    INBOX_SLOT_FRONTABLE_NAME,
+    INBOX_SLOT_FRONTABLE_COLOR,
+    INBOX_SLOT_FRONTABLE_PRONOUNS,
+    INBOX_SLOT_FRONTABLE_IS_CUSTOM,
+    INBOX_SLOT_FRONTABLE_GROUP_BIT_FIELD,
+
+    INBOX_SLOT_NUM_TOTAL_GROUPS,
+    INBOX_SLOT_NUM_GROUPS_IN_BATCH,
+    INBOX_SLOT_GROUP_NAME,
+    INBOX_SLOT_GROUP_COLOR,
+    INBOX_SLOT_GROUP_PARENT_INDEX,
+
+    INBOX_SLOT_DATA_REVISION,
+    INBOX_SLOT_DATA_FULL_FRONTABLES,
+    INBOX_SLOT_DATA_FULL_GROUPS,
+
+    INBOX_SLOT_API_KEY_VALID,
+    INBOX_SLOT_ERROR_MESSAGE,
+
+    INBOX_SLOT_TRACE_DUMP_REQUEST,
+
+    INBOX_SLOT_COUNT
+} InboxSlot;
+
+// streams are the independent decoders a message can feed,
+//   decoders only run for streams that had a tuple routed to them
+typedef enum {
+    INBOX_STREAM_SETTINGS = 1 << 0,
+    INBOX_STREAM_GROUPS = 1 << 1,
+    INBOX_STREAM_FRONTABLES = 1 << 2,
+    INBOX_STREAM_CURRENT_FRONTS = 1 << 3,
+    INBOX_STREAM_ERRORS = 1 << 4,
+    INBOX_STREAM_DEBUG = 1 << 5
+} InboxStream;
+
+typedef struct {
+    Tuple* slots[INBOX_SLOT_COUNT];
+    uint8_t streams;
+} InboxFrame;
+
+typedef struct {
+    const uint32_t* key;
+    InboxSlot slot;
+    InboxStream stream;
+} InboxRoute;
+
+// message keys aren't compile time constants, so the table stores
+//   pointers to them and a dense lookup is built on init
+static const InboxRoute INBOX_ROUTES[] = {
+    {&MESSAGE_KEY_AccentColor, INBOX_SLOT_ACCENT_COLOR, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_BackgroundColor, INBOX_SLOT_BACKGROUND_COLOR, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_CompactMemberList, INBOX_SLOT_COMPACT_MEMBER_LIST, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_MemberColorHighlight, INBOX_SLOT_MEMBER_COLOR_HIGHLIGHT, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_MemberColorTag, INBOX_SLOT_MEMBER_COLOR_TAG, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_GlobalFronterAccent, INBOX_SLOT_GLOBAL_FRONTER_ACCENT, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_GroupTitleAccent, INBOX_SLOT_GROUP_TITLE_ACCENT, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_HideMembersInRoot, INBOX_SLOT_HIDE_MEMBERS_IN_ROOT, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_ShowPronouns, INBOX_SLOT_SHOW_PRONOUNS, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_ShowTimeFronting, INBOX_SLOT_SHOW_TIME_FRONTING, INBOX_STREAM_SETTINGS},
+    {&MESSAGE_KEY_CustomFrontText, INBOX_SLOT_CUSTOM_FRONT_TEXT, INBOX_STREAM_SETTINGS},
+
+    {&MESSAGE_KEY_NumCurrentFronters, INBOX_SLOT_NUM_CURRENT_FRONTERS, INBOX_STREAM_CURRENT_FRONTS},
+    {&MESSAGE_KEY_NumCurrentFrontersInBatch, INBOX_SLOT_NUM_CURRENT_FRONTERS_IN_BATCH, INBOX_STREAM_CURRENT_FRONTS},
+    {&MESSAGE_KEY_CurrentFronter, INBOX_SLOT_CURRENT_FRONTER, INBOX_STREAM_CURRENT_FRONTS},
+    {&MESSAGE_KEY_CurrentFrontStartTime, INBOX_SLOT_CURRENT_FRONT_START_TIME, INBOX_STREAM_CURRENT_FRONTS},
+
+    {&MESSAGE_KEY_NumTotalFrontables, INBOX_SLOT_NUM_TOTAL_FRONTABLES, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_NumFrontablesInBatch, INBOX_SLOT_NUM_FRONTABLES_IN_BATCH, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontableId, INBOX_SLOT_FRONTABLE_ID, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontableName, INBOX_SLOT_FRONTABLE_NAME, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontableColor, INBOX_SLOT_FRONTABLE_COLOR, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontablePronouns, INBOX_SLOT_FRONTABLE_PRONOUNS, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontableIsCustom, INBOX_SLOT_FRONTABLE_IS_CUSTOM, INBOX_STREAM_FRONTABLES},
+    {&MESSAGE_KEY_FrontableGroupBitField, INBOX_SLOT_FRONTABLE_GROUP_BIT_FIELD, INBOX_STREAM_FRONTABLES},
+
+    {&MESSAGE_KEY_NumTotalGroups, INBOX_SLOT_NUM_TOTAL_GROUPS, INBOX_STREAM_GROUPS},
+    {&MESSAGE_KEY_NumGroupsInBatch, INBOX_SLOT_NUM_GROUPS_IN_BATCH, INBOX_STREAM_GROUPS},
+    {&MESSAGE_KEY_GroupName, INBOX_SLOT_GROUP_NAME, INBOX_STREAM_GROUPS},
+    {&MESSAGE_KEY_GroupColor, INBOX_SLOT_GROUP_COLOR, INBOX_STREAM_GROUPS},
+    {&MESSAGE_KEY_GroupParentIndex, INBOX_SLOT_GROUP_PARENT_INDEX, INBOX_STREAM_GROUPS},
+
+    // rides along with the first message of a data batch, no decoder
+    {&MESSAGE_KEY_DataRevision, INBOX_SLOT_DATA_REVISION, 0},
+    {&MESSAGE_KEY_DataFullFrontables, INBOX_SLOT_DATA_FULL_FRONTABLES, 0},
+    {&MESSAGE_KEY_DataFullGroups, INBOX_SLOT_DATA_FULL_GROUPS, 0},
+
+    {&MESSAGE_KEY_ApiKeyValid, INBOX_SLOT_API_KEY_VALID, INBOX_STREAM_ERRORS},
+    {&MESSAGE_KEY_ErrorMessage, INBOX_SLOT_ERROR_MESSAGE, INBOX_STREAM_ERRORS},
+
+    {&MESSAGE_KEY_TraceDumpRequest, INBOX_SLOT_TRACE_DUMP_REQUEST, INBOX_STREAM_DEBUG},
+};
+
+#define INBOX_ROUTE_NONE 0xFF
+
+// message keys are assigned sequentially, so their span stays close to
+//   the number of keys in package.json. past this it falls back to a scan
+#define ROUTE_LOOKUP_MAX_SIZE 64
+
+// maps (message key - route_key_min) to an index in INBOX_ROUTES
+static uint8_t route_lookup[ROUTE_LOOKUP_MAX_SIZE];
+static uint32_t route_key_min = 0;
+static uint32_t route_lookup_size = 0;
+
 static bool frontables_being_sent = false;
 static bool groups_being_sent = false;
 static bool current_fronts_being_sent = false;
 
-static void handle_settings_inbox(DictionaryIterator* iter, ClaySettings* settings, bool* update_colors) {
-    Tuple* accent_color = dict_find(iter, MESSAGE_KEY_AccentColor);
+// revision of the phone's data the watch last fully received, only
+//   taken on once the whole batch is flushed so half a batch never
+//   counts. 0 means nothing was received this session
+static uint32_t data_revision = 0;
+static uint32_t pending_data_revision = 0;
+
+// what the phone was last told to send, it keeps sending full data
+//   until it hears otherwise. MEMORY_LEVEL_COUNT means never told
+static MemoryLevel reported_memory_level = MEMORY_LEVEL_COUNT;
+static uint16_t reported_max_frontables = 0;
+
+static void build_route_lookup() {
+    uint32_t key_max = 0;
+    route_key_min = UINT32_MAX;
+
+    for (uint8_t i = 0; i < ARRAY_LENGTH(INBOX_ROUTES); i++) {
+        uint32_t key = *INBOX_ROUTES[i].key;
+        if (key < route_key_min) route_key_min = key;
+        if (key > key_max) key_max = key;
+    }
+
+    route_lookup_size = key_max - route_key_min + 1;
+    if (route_lookup_size > ROUTE_LOOKUP_MAX_SIZE) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Message keys span %lu, routing by scan!", route_lookup_size);
+        route_lookup_size = 0;
+        return;
+    }
+
+    memset(route_lookup, INBOX_ROUTE_NONE, sizeof(route_lookup));
+
+    for (uint8_t i = 0; i < ARRAY_LENGTH(INBOX_ROUTES); i++) {
+        route_lookup[*INBOX_ROUTES[i].key - route_key_min] = i;
+    }
+}
+
+static const InboxRoute* find_route(uint32_t key) {
+    if (route_lookup_size == 0) {
+        for (uint8_t i = 0; i < ARRAY_LENGTH(INBOX_ROUTES); i++) {
+            if (*INBOX_ROUTES[i].key == key) {
+                return &INBOX_ROUTES[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    if (key < route_key_min || key - route_key_min >= route_lookup_size) {
+        return NULL;
+    }
+
+    uint8_t index = route_lookup[key - route_key_min];
+    if (index == INBOX_ROUTE_NONE) {
+        return NULL;
+    }
+
+    return &INBOX_ROUTES[index];
+}
+
+// walks the dictionary exactly once, routing each tuple into its slot
+static void read_inbox_frame(DictionaryIterator* iter, InboxFrame* frame) {
+    memset(frame, 0, sizeof(InboxFrame));
+
+    for (Tuple* t = dict_read_first(iter); t != NULL; t = dict_read_next(iter)) {
+        const InboxRoute* route = find_route(t->key);
+        if (route != NULL) {
+            frame->slots[route->slot] = t;
+            frame->streams |= route->stream;
+        }
+    }
+}
+
+static void handle_settings_inbox(InboxFrame* frame, ClaySettings* settings, bool* update_colors) {
+    Tuple* accent_color = frame->slots[INBOX_SLOT_ACCENT_COLOR];
     if (accent_color != NULL) {
         settings->accent_color = GColorFromHEX(accent_color->value->int32);
         *update_colors = true;
     }
 
-    Tuple* background_color = dict_find(iter, MESSAGE_KEY_BackgroundColor);
+    Tuple* background_color = frame->slots[INBOX_SLOT_BACKGROUND_COLOR];
     if (background_color != NULL) {
         settings->background_color = GColorFromHEX(background_color->value->int32);
         *update_colors = true;
     }
 
-    Tuple* compact_member_list = dict_find(iter, MESSAGE_KEY_CompactMemberList);
+    Tuple* compact_member_list = frame->slots[INBOX_SLOT_COMPACT_MEMBER_LIST];
     if (compact_member_list != NULL) {
         settings->compact_member_list = compact_member_list->value->int16;
         *update_colors = true;
     }
 
-    Tuple* member_color_highlight = dict_find(iter, MESSAGE_KEY_MemberColorHighlight);
+    Tuple* member_color_highlight = frame->slots[INBOX_SLOT_MEMBER_COLOR_HIGHLIGHT];
     if (member_color_highlight != NULL) {
         settings->member_color_highlight = PBL_IF_COLOR_ELSE(
             member_color_highlight->value->int16,
@@ -51,7 +264,7 @@ static void handle_settings_inbox(DictionaryIterator* iter, ClaySettings* settin
         *update_colors = true;
     }
 
-    Tuple* member_color_tag = dict_find(iter, MESSAGE_KEY_MemberColorTag);
+    Tuple* member_color_tag = frame->slots[INBOX_SLOT_MEMBER_COLOR_TAG];
     if (member_color_tag != NULL) {
         settings->member_color_tag = PBL_IF_COLOR_ELSE(
             member_color_tag->value->int16,
@@ -60,7 +273,7 @@ static void handle_settings_inbox(DictionaryIterator* iter, ClaySettings* settin
         *update_colors = true;
     }
 
-    Tuple* global_fronter_accent = dict_find(iter, MESSAGE_KEY_GlobalFronterAccent);
+    Tuple* global_fronter_accent = frame->slots[INBOX_SLOT_GLOBAL_FRONTER_ACCENT];
     if (global_fronter_accent != NULL) {
         settings->global_fronter_accent = PBL_IF_COLOR_ELSE(
             global_fronter_accent->value->int16,
@@ -69,7 +282,7 @@ static void handle_settings_inbox(DictionaryIterator* iter, ClaySettings* settin
         *update_colors = true;
     }
 
-    Tuple* group_title_accent = dict_find(iter, MESSAGE_KEY_GroupTitleAccent);
+    Tuple* group_title_accent = frame->slots[INBOX_SLOT_GROUP_TITLE_ACCENT];
     if (group_title_accent != NULL) {
         settings->group_title_accent = PBL_IF_COLOR_ELSE(
             group_title_accent->value->int16,
@@ -78,25 +291,26 @@ static void handle_settings_inbox(DictionaryIterator* iter, ClaySettings* settin
         *update_colors = true;
     }
 
-    Tuple* hide_members_in_root = dict_find(iter, MESSAGE_KEY_HideMembersInRoot);
+    Tuple* hide_members_in_root = frame->slots[INBOX_SLOT_HIDE_MEMBERS_IN_ROOT];
     if (hide_members_in_root != NULL) {
         settings->hide_members_in_root = hide_members_in_root->value->int16;
         *update_colors = true;
         members_menu_remove_groups();
         members_menu_create_groups();
+        members_menu_refresh_groupless_members();
     }
 
-    Tuple* show_pronouns = dict_find(iter, MESSAGE_KEY_ShowPronouns);
+    Tuple* show_pronouns = frame->slots[INBOX_SLOT_SHOW_PRONOUNS];
     if (show_pronouns != NULL) {
         settings->show_pronouns = show_pronouns->value->int16;
     }
 
-    Tuple* show_time_fronting = dict_find(iter, MESSAGE_KEY_ShowTimeFronting);
+    Tuple* show_time_fronting = frame->slots[INBOX_SLOT_SHOW_TIME_FRONTING];
     if (show_time_fronting != NULL) {
         settings->show_time_fronting = show_time_fronting->value->int16;
     }
 
-    Tuple* custom_front_text = dict_find(iter, MESSAGE_KEY_CustomFrontText);
+    Tuple* custom_front_text = frame->slots[INBOX_SLOT_CUSTOM_FRONT_TEXT];
     if (custom_front_text != NULL) {
         strncpy(settings->custom_front_text, custom_front_text->value->cstring, sizeof(settings->custom_front_text) - 1);
     }
@@ -111,13 +325,20 @@ static uint32_t uint32_from_byte_arr(uint8_t* start) {
     return num;
 }
 
+static uint16_t uint16_from_byte_arr(uint8_t* start) {
+    uint16_t num = 0;
+    num |= (start[0] & 0xFF) << 8;
+    num |= (start[1] & 0xFF) << 0;
+    return num;
+}
+
 // returns whether or not data has finished sending
-static bool handle_api_frontables(DictionaryIterator* iter) {
+static bool handle_api_frontables(InboxFrame* frame) {
     // using regular ints here so APP_LOG printf doesn't yell at me lol
     static int frontable_counter = 0;
     static int total_frontables = 0;
 
-    Tuple* num_total_frontables = dict_find(iter, MESSAGE_KEY_NumTotalFrontables);
+    Tuple* num_total_frontables = frame->slots[INBOX_SLOT_NUM_TOTAL_FRONTABLES];
     if (num_total_frontables != NULL) {
         total_frontables = num_total_frontables->value->int32;
         frontable_counter = 0;
@@ -131,19 +352,21 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
         frontables_being_sent = true;
     }
 
-    Tuple* frontable_hash = dict_find(iter, MESSAGE_KEY_FrontableHash);
-    Tuple* frontable_name = dict_find(iter, MESSAGE_KEY_FrontableName);
-    Tuple* frontable_color = dict_find(iter, MESSAGE_KEY_FrontableColor);
-    Tuple* frontable_pronouns = dict_find(iter, MESSAGE_KEY_FrontablePronouns);
-    Tuple* frontable_is_custom = dict_find(iter, MESSAGE_KEY_FrontableIsCustom);
-    Tuple* frontable_group_bits = dict_find(iter, MESSAGE_KEY_FrontableGroupBitField);
-    Tuple* frontable_batch_size = dict_find(iter, MESSAGE_KEY_NumFrontablesInBatch);
+    Tuple* frontable_id = frame->slots[INBOX_SLOT_FRONTABLE_ID];
+    Tuple* frontable_name = frame->slots[INBOX_SLOT_FRONTABLE_NAME];
+    Tuple* frontable_color = frame->slots[INBOX_SLOT_FRONTABLE_COLOR];
+    Tuple* frontable_pronouns = frame->slots[INBOX_SLOT_FRONTABLE_PRONOUNS];
+    Tuple* frontable_is_custom = frame->slots[INBOX_SLOT_FRONTABLE_IS_CUSTOM];
+    Tuple* frontable_group_bits = frame->slots[INBOX_SLOT_FRONTABLE_GROUP_BIT_FIELD];
+    Tuple* frontable_batch_size = frame->slots[INBOX_SLOT_NUM_FRONTABLES_IN_BATCH];
 
-    bool recieved_frontables = false;
+    // counts entries skipped by the governor too, so the sequence
+    //   still ends when its whole tail was dropped
+    bool consumed_frontables = false;
 
     // handle frontable byte data being sent
     if (
-        frontable_hash != NULL &&
+        frontable_id != NULL &&
         frontable_name != NULL &&
         frontable_color != NULL &&
         frontable_pronouns != NULL &&
@@ -152,7 +375,7 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
         frontable_batch_size != NULL
     ) {
         int32_t batch_size = frontable_batch_size->value->int32;
-        uint8_t* hash_byte_arr = frontable_hash->value->data;
+        uint8_t* id_byte_arr = frontable_id->value->data;
         uint8_t* color_byte_arr = frontable_color->value->data;
         uint8_t* is_custom_byte_arr = frontable_is_custom->value->data;
         char* names_combined = frontable_name->value->cstring;
@@ -165,7 +388,17 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
         char** pronouns = string_split(pronouns_combined, DELIMETER, &pronouns_length);
 
         for (int32_t i = 0; i < batch_size; i++) {
-            uint32_t hash = uint32_from_byte_arr(hash_byte_arr + (i * sizeof(uint32_t)));
+            memory_governor_check(frontable_counter);
+
+            // tail members are the last thing to go, still counted so
+            //   the end of the sequence is recognized
+            if (frontable_counter >= memory_governor_get_max_frontables()) {
+                frontable_counter++;
+                consumed_frontables = true;
+                continue;
+            }
+
+            uint16_t id = uint16_from_byte_arr(id_byte_arr + (i * sizeof(uint16_t)));
             uint32_t bitfield = uint32_from_byte_arr(group_bits_byte_arr + (i * sizeof(uint32_t)));
             // uint32_t bitfield_one = uint32_from_byte_arr(group_bits_byte_arr + ((i * 2) * sizeof(uint32_t)));
             // uint32_t bitfield_two = uint32_from_byte_arr(group_bits_byte_arr + ((i * 2 + 1) * sizeof(uint32_t)));
@@ -173,17 +406,26 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
             uint8_t color = color_byte_arr[i];
 
             Frontable* f = frontable_create(
-                hash,
+                id,
                 names[i],
-                pronouns[i],
+                memory_governor_is_shedding(MEMORY_LEVEL_NO_PRONOUNS) ? NULL : pronouns[i],
                 is_custom,
                 (GColor) {.argb = color}
             );
+            if (f == NULL) {
+                // the rest of the batch gets skipped like any other truncated tail
+                APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Out of memory at frontable %d, truncating!", frontable_counter);
+                memory_governor_truncate(frontable_counter);
+                frontable_counter++;
+                consumed_frontables = true;
+                continue;
+            }
+
             f->group_bit_field = bitfield;
             // f->group_bit_field = (uint64_t)bitfield_one | ((uint64_t)bitfield_two << 32);
 
             cache_queue_add_frontable(f);
-            recieved_frontables = true;
+            consumed_frontables = true;
 
             frontable_counter++;
             APP_LOG(
@@ -199,7 +441,7 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
         string_array_free(pronouns, pronouns_length);
     }
 
-    if (frontable_counter >= total_frontables && recieved_frontables) {
+    if (frontable_counter >= total_frontables && consumed_frontables) {
         APP_LOG(APP_LOG_LEVEL_INFO, "All frontables recieved!");
 
         total_frontables = 0;
@@ -207,7 +449,7 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
 
         return true;
 
-    } else if (!recieved_frontables) {
+    } else if (!consumed_frontables) {
         APP_LOG(APP_LOG_LEVEL_INFO, "No frontables in message detected!");
     }
 
@@ -222,12 +464,12 @@ static bool handle_api_frontables(DictionaryIterator* iter) {
 }
 
 // returns whether or not data has finished sending
-static bool handle_api_current_fronts(DictionaryIterator* iter) {
+static bool handle_api_current_fronts(InboxFrame* frame) {
     // using regular ints here so APP_LOG printf doesn't yell at me lol
     static int current_front_counter = 0;
     static int total_current_fronters = 0;
 
-    Tuple* num_current_fronters = dict_find(iter, MESSAGE_KEY_NumCurrentFronters);
+    Tuple* num_current_fronters = frame->slots[INBOX_SLOT_NUM_CURRENT_FRONTERS];
     if (num_current_fronters != NULL) {
         total_current_fronters = num_current_fronters->value->int32;
         current_front_counter = 0;
@@ -242,9 +484,9 @@ static bool handle_api_current_fronts(DictionaryIterator* iter) {
     }
 
     // handle current fronters byte data being sent
-    Tuple* current_fronter = dict_find(iter, MESSAGE_KEY_CurrentFronter);
-    Tuple* current_fronter_start_time = dict_find(iter, MESSAGE_KEY_CurrentFrontStartTime);
-    Tuple* current_fronter_batch_size = dict_find(iter, MESSAGE_KEY_NumCurrentFrontersInBatch);
+    Tuple* current_fronter = frame->slots[INBOX_SLOT_CURRENT_FRONTER];
+    Tuple* current_fronter_start_time = frame->slots[INBOX_SLOT_CURRENT_FRONT_START_TIME];
+    Tuple* current_fronter_batch_size = frame->slots[INBOX_SLOT_NUM_CURRENT_FRONTERS_IN_BATCH];
     if (
         current_fronter != NULL &&
         current_fronter_start_time != NULL &&
@@ -252,22 +494,22 @@ static bool handle_api_current_fronts(DictionaryIterator* iter) {
     ) {
         int32_t batch_size = current_fronter_batch_size->value->int32;
 
-        uint8_t* hash_byte_arr = current_fronter->value->data;
+        uint8_t* id_byte_arr = current_fronter->value->data;
         uint8_t* start_time_byte_arr = current_fronter_start_time->value->data;
 
         for (int32_t i = 0; i < batch_size; i++) {
-            uint32_t hash = uint32_from_byte_arr(hash_byte_arr + (i * sizeof(uint32_t)));
+            uint16_t id = uint16_from_byte_arr(id_byte_arr + (i * sizeof(uint16_t)));
             uint32_t time_started_fronting = uint32_from_byte_arr(
                 start_time_byte_arr + (i * sizeof(uint32_t))
             );
 
-            cache_queue_add_current_fronter(hash, time_started_fronting);
+            cache_queue_add_current_fronter(id, time_started_fronting);
 
             current_front_counter++;
             APP_LOG(
                 APP_LOG_LEVEL_DEBUG,
-                "Recieved current front '%lu'! Index: %d/%d",
-                hash,
+                "Recieved current front '%d'! Index: %d/%d",
+                (int)id,
                 current_front_counter,
                 total_current_fronters
             );
@@ -290,7 +532,7 @@ static bool handle_api_current_fronts(DictionaryIterator* iter) {
 }
 
 // returns whether or not data has finished sending
-static bool handle_api_groups(DictionaryIterator* iter) {
+static bool handle_api_groups(InboxFrame* frame) {
     static uint8_t parent_index_arr[GROUP_LIST_MAX_COUNT];
     static int32_t parent_index_counter = 0;
 
@@ -299,7 +541,7 @@ static bool handle_api_groups(DictionaryIterator* iter) {
     static int total_groups = 0;
     static Group** groups_to_set = NULL;
 
-    Tuple* num_total_groups = dict_find(iter, MESSAGE_KEY_NumTotalGroups);
+    Tuple* num_total_groups = frame->slots[INBOX_SLOT_NUM_TOTAL_GROUPS];
     if (num_total_groups != NULL) {
         total_groups = num_total_groups->value->int32;
         group_counter = 0;
@@ -310,7 +552,7 @@ static bool handle_api_groups(DictionaryIterator* iter) {
             total_groups
         );
 
-        groups_to_set = malloc(sizeof(Group*) * total_groups);
+        groups_to_set = heap_stats_malloc(HEAP_TAG_MESSAGING, sizeof(Group*) * total_groups);
 
         memset(parent_index_arr, 0, sizeof(uint8_t) * total_groups);
         parent_index_counter = 0;
@@ -318,10 +560,10 @@ static bool handle_api_groups(DictionaryIterator* iter) {
         groups_being_sent = true;
     }
 
-    Tuple* group_name = dict_find(iter, MESSAGE_KEY_GroupName);
-    Tuple* group_color = dict_find(iter, MESSAGE_KEY_GroupColor);
-    Tuple* group_batch_size = dict_find(iter, MESSAGE_KEY_NumGroupsInBatch);
-    Tuple* group_parent_index = dict_find(iter, MESSAGE_KEY_GroupParentIndex);
+    Tuple* group_name = frame->slots[INBOX_SLOT_GROUP_NAME];
+    Tuple* group_color = frame->slots[INBOX_SLOT_GROUP_COLOR];
+    Tuple* group_batch_size = frame->slots[INBOX_SLOT_NUM_GROUPS_IN_BATCH];
+    Tuple* group_parent_index = frame->slots[INBOX_SLOT_GROUP_PARENT_INDEX];
 
     bool recieved_groups = false;
 
@@ -384,7 +626,7 @@ static bool handle_api_groups(DictionaryIterator* iter) {
             cache_queue_add_group(groups_to_set[i]);
         }
 
-        free(groups_to_set);
+        heap_stats_free(groups_to_set);
         groups_to_set = NULL;
         total_groups = 0;
         group_counter = 0;
@@ -416,32 +658,118 @@ static void flush_cache_groups_and_frontables() {
 
     members_menu_refresh_groupless_members();
 
+    // frontables were re-allocated, cached row layouts may point at old ones
+    frontable_menu_invalidate_layouts();
+
+    // ids are handed out again every sync, point scores back at the right frontables
+    frecency_remap();
+    main_menu_refresh_likely();
+
     main_menu_mark_members_loaded();
     main_menu_mark_fronters_loaded();
     main_menu_mark_custom_fronts_loaded();
     main_menu_update_fetch_status(false);
     settings_menu_confirm_frontable_fetch();
+
+    persistence_mark_cache_dirty();
 }
 
 static void flush_cache_current_fronters() {
     cache_queue_flush_current_fronters();
     main_menu_update_fronters_subtitle();
     current_fronters_menu_update_is_empty();
+
+    // lists sorted by fronting may have moved under whatever's shown
+    Window* top_window = window_stack_get_top_window();
+    if (settings_get()->sort_order == SORT_ORDER_FRONTING && top_window != NULL) {
+        layer_mark_dirty(window_get_root_layer(top_window));
+    }
+
+    // fronting state is packed into the persisted frontables too
+    persistence_mark_cache_dirty();
 }
 
-static void handle_api_inbox(DictionaryIterator* iter, ClaySettings* settings, bool* update_colors) {
+static void data_limits_message() {
+    MemoryLevel level = memory_governor_get_level();
+    uint16_t max_frontables = memory_governor_get_max_frontables();
+    if (level == reported_memory_level && max_frontables == reported_max_frontables) return;
+
+    DictionaryIterator* iter;
+
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result == APP_MSG_OK) {
+        dict_write_uint8(iter, MESSAGE_KEY_DataLimitLevel, level);
+        dict_write_uint16(iter, MESSAGE_KEY_DataLimitMaxFrontables, max_frontables);
+
+        result = app_message_outbox_send();
+
+        if (result != APP_MSG_OK) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "Error sending data limits message data: %d", (int)result);
+            return;
+        }
+
+        reported_memory_level = level;
+        reported_max_frontables = max_frontables;
+
+    } else {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error preparing data limits message outbox: %d", (int)result);
+    }
+}
+
+static uint16_t get_batch_size(Tuple* batch_size) {
+    return batch_size != NULL ? batch_size->value->int32 : 0;
+}
+
+static void handle_api_inbox(InboxFrame* frame, ClaySettings* settings, bool* update_colors) {
     static bool groups_dirty = false;
     static bool frontables_dirty = false;
     static bool current_fronts_dirty = false;
 
-    if (handle_api_groups(iter)) {
-        groups_dirty = true;
+    Tuple* revision = frame->slots[INBOX_SLOT_DATA_REVISION];
+    if (revision != NULL) {
+        pending_data_revision = revision->value->uint32;
     }
-    if (handle_api_frontables(iter)) {
-        frontables_dirty = true;
+
+    // the first message of a full batch carries its totals, decide
+    //   what to shed before any of it gets allocated. the level goes off
+    //   the untrimmed totals when the phone sends them, otherwise a batch
+    //   trimmed to fit would always look like it fits at full data
+    Tuple* num_total_frontables = frame->slots[INBOX_SLOT_NUM_TOTAL_FRONTABLES];
+    if (num_total_frontables != NULL) {
+        Tuple* num_total_groups = frame->slots[INBOX_SLOT_NUM_TOTAL_GROUPS];
+        Tuple* full_frontables = frame->slots[INBOX_SLOT_DATA_FULL_FRONTABLES];
+        Tuple* full_groups = frame->slots[INBOX_SLOT_DATA_FULL_GROUPS];
+
+        uint16_t num_frontables = num_total_frontables->value->int32;
+        uint16_t num_groups = num_total_groups != NULL ? num_total_groups->value->int32 : 0;
+        if (full_frontables != NULL && full_groups != NULL) {
+            num_frontables = full_frontables->value->int32;
+            num_groups = full_groups->value->int32;
+        }
+
+        memory_governor_begin_sync(num_frontables, num_groups);
+    }
+
+    if (frame->streams & INBOX_STREAM_GROUPS) {
+        trace_record(TRACE_EVENT_PARSE_GROUPS_START, get_batch_size(frame->slots[INBOX_SLOT_NUM_GROUPS_IN_BATCH]));
+        if (handle_api_groups(frame)) {
+            groups_dirty = true;
+        }
+        trace_record(TRACE_EVENT_PARSE_GROUPS_END, 0);
+    }
+    if (frame->streams & INBOX_STREAM_FRONTABLES) {
+        trace_record(TRACE_EVENT_PARSE_FRONTABLES_START, get_batch_size(frame->slots[INBOX_SLOT_NUM_FRONTABLES_IN_BATCH]));
+        if (handle_api_frontables(frame)) {
+            frontables_dirty = true;
+        }
+        trace_record(TRACE_EVENT_PARSE_FRONTABLES_END, 0);
     }
-    if (handle_api_current_fronts(iter)) {
-        current_fronts_dirty = true;
+    if (frame->streams & INBOX_STREAM_CURRENT_FRONTS) {
+        trace_record(TRACE_EVENT_PARSE_CURRENT_FRONTS_START, get_batch_size(frame->slots[INBOX_SLOT_NUM_CURRENT_FRONTERS_IN_BATCH]));
+        if (handle_api_current_fronts(frame)) {
+            current_fronts_dirty = true;
+        }
+        trace_record(TRACE_EVENT_PARSE_CURRENT_FRONTS_END, 0);
     }
 
     // data flushing has two situations:
@@ -452,9 +780,10 @@ static void handle_api_inbox(DictionaryIterator* iter, ClaySettings* settings, b
         if (groups_dirty && frontables_dirty && current_fronts_dirty) {
             APP_LOG(APP_LOG_LEVEL_INFO, "Member && group && current_front messages dirty, flushing cache and updating app data!");
 
-            printf("free memory on heap before flush: %lu", (uint32_t)heap_bytes_free());
             flush_cache_groups_and_frontables();
             flush_cache_current_fronters();
+            data_revision = pending_data_revision;
+            trace_arm_first_draw();
 
             *update_colors = true;
 
@@ -466,29 +795,38 @@ static void handle_api_inbox(DictionaryIterator* iter, ClaySettings* settings, b
             frontables_being_sent = false;
             current_fronts_being_sent = false;
 
-            printf("free memory on heap after flush: %lu", (uint32_t)heap_bytes_free());
+            APP_LOG(
+                APP_LOG_LEVEL_INFO,
+                "Free heap after flush: %lu bytes, memory level %d",
+                (uint32_t)heap_bytes_free(),
+                (int)memory_governor_get_level()
+            );
+
+            // later syncs come in already trimmed if anything was shed
+            data_limits_message();
         }
 
     } else if (current_fronts_being_sent) {
         if (current_fronts_dirty) {
             APP_LOG(APP_LOG_LEVEL_INFO, "Current front messages dirty, flushing cache and updating app data!");
 
-            printf("free memory on heap before flush: %lu", (uint32_t)heap_bytes_free());
             flush_cache_current_fronters();
             current_fronts_dirty = false;
             current_fronts_being_sent = false;
 
             *update_colors = true;
-
-            printf("free memory on heap after flush: %lu", (uint32_t)heap_bytes_free());
         }
     }
 }
 
-static void handle_error_inbox(DictionaryIterator* iter, ClaySettings* settings) {
-    Tuple* api_key_valid = dict_find(iter, MESSAGE_KEY_ApiKeyValid);
+// returns whether or not settings were changed
+static bool handle_error_inbox(InboxFrame* frame, ClaySettings* settings) {
+    bool settings_changed = false;
+
+    Tuple* api_key_valid = frame->slots[INBOX_SLOT_API_KEY_VALID];
     if (api_key_valid != NULL) {
         settings->api_key_valid = api_key_valid->value->int16;
+        settings_changed = true;
 
         if (settings->api_key_valid && setup_prompt_menu_shown()) {
             window_stack_pop_all(false);
@@ -499,22 +837,43 @@ static void handle_error_inbox(DictionaryIterator* iter, ClaySettings* settings)
         }
     }
 
-    Tuple* error_message = dict_find(iter, MESSAGE_KEY_ErrorMessage);
+    Tuple* error_message = frame->slots[INBOX_SLOT_ERROR_MESSAGE];
     if (error_message != NULL) {
         error_menu_show(error_message->value->cstring);
     }
+
+    return settings_changed;
 }
 
 static void inbox_recieved_handler(DictionaryIterator* iter, void* context) {
     ClaySettings* settings = settings_get();
 
+    InboxFrame frame;
+    read_inbox_frame(iter, &frame);
+    trace_record(TRACE_EVENT_INBOX_RECEIVED, frame.streams);
+
     bool should_update_menu_colors = false;
+    bool settings_changed = false;
 
-    handle_settings_inbox(iter, settings, &should_update_menu_colors);
-    handle_api_inbox(iter, settings, &should_update_menu_colors);
-    handle_error_inbox(iter, settings);
+    if (frame.streams & INBOX_STREAM_SETTINGS) {
+        handle_settings_inbox(&frame, settings, &should_update_menu_colors);
+        settings_changed = true;
+    }
+    handle_api_inbox(&frame, settings, &should_update_menu_colors);
+    if (frame.streams & INBOX_STREAM_ERRORS) {
+        settings_changed |= handle_error_inbox(&frame, settings);
+    }
+    if (frame.slots[INBOX_SLOT_TRACE_DUMP_REQUEST] != NULL) {
+        messaging_send_trace();
+    }
 
-    settings_save(should_update_menu_colors);
+    // only touch storage when a setting actually changed, data batches
+    //   just need the menus refreshed once they've been flushed
+    if (settings_changed) {
+        settings_save(should_update_menu_colors);
+    } else if (should_update_menu_colors) {
+        settings_apply(true);
+    }
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void* context) {
@@ -529,21 +888,44 @@ static void outbox_failed_callback(DictionaryIterator* iter, AppMessageResult re
     APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox failed. Reason: %d", (int)reason);
 }
 
+static uint32_t max_size(uint32_t a, uint32_t b) {
+    return a > b ? a : b;
+}
+
+// every outgoing message is a single tuple, sized for the biggest one.
+//   debug payloads only count when they're compiled in
+static uint32_t get_outbox_size() {
+    uint32_t size = dict_calc_buffer_size(1, FRONT_LIST_MAX_COUNT * sizeof(uint16_t));
+#if HEAP_STATS_ENABLED
+    size = max_size(size, dict_calc_buffer_size(1, HEAP_STATS_VALUE_COUNT * sizeof(uint32_t)));
+#endif
+#if TRACE_ENABLED
+    size = max_size(size, dict_calc_buffer_size(1, TRACE_DUMP_MAX_ENTRIES * 8));
+#endif
+    return max_size(size, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
+}
+
 void messaging_init() {
+    build_route_lookup();
+
     app_message_register_inbox_received(inbox_recieved_handler);
     app_message_register_inbox_dropped(inbox_dropped_callback);
     app_message_register_outbox_sent(outbox_sent_handler);
     app_message_register_outbox_failed(outbox_failed_callback);
 
-    app_message_open(4096, APP_MESSAGE_OUTBOX_SIZE_MINIMUM);
+    app_message_open(4096, get_outbox_size());
 }
 
-static void front_message(uint32_t frontable_hash, const uint32_t message_key) {
+void messaging_deinit() {
+    route_lookup_size = 0;
+}
+
+static void front_message(uint16_t frontable_id, const uint32_t message_key) {
     DictionaryIterator* iter;
 
     AppMessageResult result = app_message_outbox_begin(&iter);
     if (result == APP_MSG_OK) {
-        dict_write_int32(iter, message_key, (frontable_hash - (0xFFFFFFFF / 2)));
+        dict_write_uint16(iter, message_key, frontable_id);
 
         result = app_message_outbox_send();
 
@@ -556,6 +938,41 @@ static void front_message(uint32_t frontable_hash, const uint32_t message_key) {
     }
 }
 
+static bool front_list_message(const uint16_t* frontable_ids, uint16_t count, const uint32_t message_key) {
+    DictionaryIterator* iter;
+
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result != APP_MSG_OK) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error preparing front list message outbox: %d", (int)result);
+        return false;
+    }
+
+    // big-endian u16s, same as ids coming in from the phone
+    uint8_t bytes[FRONT_LIST_MAX_COUNT * sizeof(uint16_t)];
+    for (uint16_t i = 0; i < count; i++) {
+        bytes[i * 2] = (frontable_ids[i] >> 8) & 0xFF;
+        bytes[i * 2 + 1] = frontable_ids[i] & 0xFF;
+    }
+
+    DictionaryResult write_result = dict_write_data(iter, message_key, bytes, count * sizeof(uint16_t));
+    if (write_result != DICT_OK) {
+        // still sent, an outbox that was begun stays locked until it is.
+        //   the phone ignores it, but the switch itself has to fail loudly
+        APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Couldn't fit front list of %u in the outbox: %d", count, (int)write_result);
+        app_message_outbox_send();
+        return false;
+    }
+
+    result = app_message_outbox_send();
+
+    if (result != APP_MSG_OK) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error sending front list message data: %d", (int)result);
+        return false;
+    }
+
+    return true;
+}
+
 static void bool_message(const uint32_t key, bool value) {
     DictionaryIterator* iter;
 
@@ -574,16 +991,48 @@ static void bool_message(const uint32_t key, bool value) {
     }
 }
 
-void messaging_add_to_front(uint32_t frontable_hash) {
-    front_message(frontable_hash, MESSAGE_KEY_AddFrontRequest);
+static void record_frontable_use(uint16_t frontable_id) {
+    Frontable* frontable = cache_get_frontable(frontable_id);
+    if (frontable != NULL) {
+        frecency_record_use(frontable);
+    }
 }
 
-void messaging_set_as_front(uint32_t frontable_hash) {
-    front_message(frontable_hash, MESSAGE_KEY_SetFrontRequest);
+void messaging_add_to_front(uint16_t frontable_id) {
+    front_message(frontable_id, MESSAGE_KEY_AddFrontRequest);
+    record_frontable_use(frontable_id);
 }
 
-void messaging_remove_from_front(uint32_t frontable_hash) {
-    front_message(frontable_hash, MESSAGE_KEY_RemoveFrontRequest);
+void messaging_set_as_front(uint16_t frontable_id) {
+    front_message(frontable_id, MESSAGE_KEY_SetFrontRequest);
+    record_frontable_use(frontable_id);
+}
+
+bool messaging_set_front_list(const uint16_t* frontable_ids, uint16_t count) {
+    if (count == 0) return false;
+
+    // a cut down switch isn't what was asked for, so refuse instead
+    if (count > FRONT_LIST_MAX_COUNT) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "WARNING: Front list of %u is longer than the max of %u!", count, FRONT_LIST_MAX_COUNT);
+        error_menu_show("Too many to front at once!");
+        return false;
+    }
+
+    // one message for the whole list, the phone turns it into one switch
+    if (!front_list_message(frontable_ids, count, MESSAGE_KEY_SetFrontListRequest)) {
+        error_menu_show("Couldn't send switch to phone :(");
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        record_frontable_use(frontable_ids[i]);
+    }
+
+    return true;
+}
+
+void messaging_remove_from_front(uint16_t frontable_id) {
+    front_message(frontable_id, MESSAGE_KEY_RemoveFrontRequest);
 }
 
 void messaging_fetch_data() {
@@ -594,3 +1043,110 @@ void messaging_fetch_data() {
 void messaging_clear_cache() {
     bool_message(MESSAGE_KEY_ClearCacheRequest, true);
 }
+
+void messaging_request_catch_up() {
+    DictionaryIterator* iter;
+
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result == APP_MSG_OK) {
+        // the phone only re-sends everything if this is out of date
+        dict_write_uint32(iter, MESSAGE_KEY_CatchUpRequest, data_revision);
+
+        result = app_message_outbox_send();
+
+        if (result != APP_MSG_OK) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "Error sending catch up message data: %d", (int)result);
+        }
+
+    } else {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error preparing catch up message outbox: %d", (int)result);
+    }
+}
+
+void messaging_send_heap_stats() {
+#if HEAP_STATS_ENABLED
+    DictionaryIterator* iter;
+
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result == APP_MSG_OK) {
+        // big-endian u32s: free now, lowest free, then live, peak,
+        //   allocs and failed allocs for every tag in order
+        uint8_t bytes[HEAP_STATS_VALUE_COUNT * sizeof(uint32_t)];
+        uint32_t values[HEAP_STATS_VALUE_COUNT];
+
+        values[0] = heap_bytes_free();
+        values[1] = heap_stats_get_min_free();
+        for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+            const HeapTagStats* stats = heap_stats_get(i);
+            values[2 + i * 4] = stats->live_bytes;
+            values[2 + i * 4 + 1] = stats->peak_bytes;
+            values[2 + i * 4 + 2] = stats->num_allocs;
+            values[2 + i * 4 + 3] = stats->num_failed;
+        }
+
+        for (uint8_t i = 0; i < ARRAY_LENGTH(values); i++) {
+            bytes[i * 4] = (values[i] >> 24) & 0xFF;
+            bytes[i * 4 + 1] = (values[i] >> 16) & 0xFF;
+            bytes[i * 4 + 2] = (values[i] >> 8) & 0xFF;
+            bytes[i * 4 + 3] = values[i] & 0xFF;
+        }
+
+        DictionaryResult write_result = dict_write_data(iter, MESSAGE_KEY_HeapStats, bytes, sizeof(bytes));
+        if (write_result != DICT_OK) {
+            // still sent so the outbox isn't left locked, the phone ignores it
+            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Couldn't fit heap stats in the outbox: %d", (int)write_result);
+        }
+
+        result = app_message_outbox_send();
+
+        if (result != APP_MSG_OK) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "Error sending heap stats message data: %d", (int)result);
+        }
+
+    } else {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error preparing heap stats message outbox: %d", (int)result);
+    }
+#endif
+}
+
+void messaging_send_trace() {
+#if TRACE_ENABLED
+    TraceEntry entries[TRACE_DUMP_MAX_ENTRIES];
+    uint8_t count = trace_copy(entries, TRACE_DUMP_MAX_ENTRIES);
+
+    DictionaryIterator* iter;
+
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result == APP_MSG_OK) {
+        // 8 bytes per event, oldest first: big-endian u32 ms,
+        //   big-endian u16 arg, u8 event and a byte of padding
+        uint8_t bytes[TRACE_DUMP_MAX_ENTRIES * 8];
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t* entry = bytes + (i * 8);
+            entry[0] = (entries[i].time >> 24) & 0xFF;
+            entry[1] = (entries[i].time >> 16) & 0xFF;
+            entry[2] = (entries[i].time >> 8) & 0xFF;
+            entry[3] = entries[i].time & 0xFF;
+            entry[4] = (entries[i].arg >> 8) & 0xFF;
+            entry[5] = entries[i].arg & 0xFF;
+            entry[6] = entries[i].event;
+            entry[7] = 0;
+        }
+
+        DictionaryResult write_result = dict_write_data(iter, MESSAGE_KEY_TraceDump, bytes, count * 8);
+        if (write_result != DICT_OK) {
+            // still sent so the outbox isn't left locked, the phone ignores it
+            APP_LOG(APP_LOG_LEVEL_ERROR, "ERROR! Couldn't fit trace of %u events in the outbox: %d", count, (int)write_result);
+        }
+
+        result = app_message_outbox_send();
+
+        if (result != APP_MSG_OK) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "Error sending trace message data: %d", (int)result);
+        }
+
+    } else {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Error preparing trace message outbox: %d", (int)result);
+    }
+#endif
+}
@@ -3,8 +3,13 @@
 #include "../frontables/frontable.h"
 
 void messaging_init();
-void messaging_add_to_front(uint32_t frontable_hash);
-void messaging_set_as_front(uint32_t frontable_hash);
-void messaging_remove_from_front(uint32_t frontable_hash);
+void messaging_deinit();
+void messaging_add_to_front(uint16_t frontable_id);
+void messaging_set_as_front(uint16_t frontable_id);
+void messaging_remove_from_front(uint16_t frontable_id);
+bool messaging_set_front_list(const uint16_t* frontable_ids, uint16_t count);
 void messaging_fetch_data();
 void messaging_clear_cache();
+void messaging_request_catch_up();
+void messaging_send_heap_stats();
+void messaging_send_trace();
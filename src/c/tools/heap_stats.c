@@ -0,0 +1,130 @@
+#include "heap_stats.h"
+
+#if HEAP_STATS_ENABLED
+
+// every allocation is prefixed with one word, size in the low
+//   24 bits and tag in the top 8, so frees know what to subtract.
+//   keeps 4 byte alignment, nothing on the heap needs more
+#define HEADER_SIZE sizeof(uint32_t)
+#define HEADER_SIZE_MASK 0x00FFFFFF
+#define HEADER_TAG_SHIFT 24
+
+static const char* TAG_NAMES[HEAP_TAG_COUNT] = {
+    "Frontables",
+    "Lists",
+    "Groups",
+    "Cache",
+    "Queues",
+    "Messaging",
+    "Strings",
+    "Menus"
+};
+
+static HeapTagStats stats[HEAP_TAG_COUNT];
+static uint32_t min_free = UINT32_MAX;
+
+static void count_bytes(HeapTag tag, int32_t bytes) {
+    HeapTagStats* tag_stats = &stats[tag];
+
+    tag_stats->live_bytes += bytes;
+    if (bytes > 0) {
+        tag_stats->num_allocs++;
+    }
+    if (tag_stats->live_bytes > tag_stats->peak_bytes) {
+        tag_stats->peak_bytes = tag_stats->live_bytes;
+    }
+
+    uint32_t free_bytes = heap_bytes_free();
+    if (free_bytes < min_free) {
+        min_free = free_bytes;
+    }
+}
+
+static uint32_t* get_header(void* ptr) {
+    return (uint32_t*)ptr - 1;
+}
+
+void* heap_stats_malloc(HeapTag tag, size_t size) {
+    uint32_t* header = malloc(HEADER_SIZE + size);
+    if (header == NULL) {
+        stats[tag].num_failed++;
+        return NULL;
+    }
+
+    *header = (size & HEADER_SIZE_MASK) | ((uint32_t)tag << HEADER_TAG_SHIFT);
+    count_bytes(tag, size);
+
+    return header + 1;
+}
+
+void* heap_stats_realloc(HeapTag tag, void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return heap_stats_malloc(tag, size);
+    }
+
+    uint32_t old_header = *get_header(ptr);
+
+    uint32_t* header = realloc(get_header(ptr), HEADER_SIZE + size);
+    if (header == NULL) {
+        stats[tag].num_failed++;
+        return NULL;
+    }
+
+    *header = (size & HEADER_SIZE_MASK) | ((uint32_t)tag << HEADER_TAG_SHIFT);
+    count_bytes(old_header >> HEADER_TAG_SHIFT, -(int32_t)(old_header & HEADER_SIZE_MASK));
+    count_bytes(tag, size);
+
+    return header + 1;
+}
+
+void heap_stats_free(void* ptr) {
+    if (ptr == NULL) return;
+
+    uint32_t* header = get_header(ptr);
+    count_bytes(*header >> HEADER_TAG_SHIFT, -(int32_t)(*header & HEADER_SIZE_MASK));
+
+    free(header);
+}
+
+uint32_t heap_stats_mark() {
+    return heap_bytes_free();
+}
+
+void heap_stats_account(HeapTag tag, uint32_t mark) {
+    count_bytes(tag, (int32_t)mark - (int32_t)heap_bytes_free());
+}
+
+const HeapTagStats* heap_stats_get(HeapTag tag) {
+    return &stats[tag];
+}
+
+const char* heap_stats_get_tag_name(HeapTag tag) {
+    return TAG_NAMES[tag];
+}
+
+uint32_t heap_stats_get_min_free() {
+    return min_free;
+}
+
+void heap_stats_log() {
+    APP_LOG(
+        APP_LOG_LEVEL_INFO,
+        "Heap stats: %lu bytes free now, %lu at lowest",
+        (uint32_t)heap_bytes_free(),
+        heap_stats_get_min_free()
+    );
+
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+        APP_LOG(
+            APP_LOG_LEVEL_INFO,
+            "  %s: %ld live, %ld peak, %lu allocs, %lu failed",
+            TAG_NAMES[i],
+            stats[i].live_bytes,
+            stats[i].peak_bytes,
+            stats[i].num_allocs,
+            stats[i].num_failed
+        );
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <pebble.h>
+
+// flip on to see where the heap goes, adds a debug screen to settings
+//   and costs 4 bytes per allocation so it's off for release builds
+#define HEAP_STATS_ENABLED 0
+
+/// @brief Subsystems heap usage is tracked for
+typedef enum {
+    HEAP_TAG_FRONTABLES,
+    HEAP_TAG_LISTS,
+    HEAP_TAG_GROUPS,
+    HEAP_TAG_CACHE,
+    HEAP_TAG_QUEUES,
+    HEAP_TAG_MESSAGING,
+    HEAP_TAG_STRINGS,
+    HEAP_TAG_MENUS,
+    HEAP_TAG_COUNT
+} HeapTag;
+
+/// @brief Heap usage of a single tag
+typedef struct {
+    int32_t live_bytes;
+    int32_t peak_bytes;
+    uint32_t num_allocs;
+    uint32_t num_failed;
+} HeapTagStats;
+
+#if HEAP_STATS_ENABLED
+
+/// @brief Allocates memory on the heap, counted towards a tag
+/// @param tag Tag to count allocation towards
+/// @param size Size in bytes to allocate
+/// @return Pointer to allocated memory, NULL if allocation failed
+void* heap_stats_malloc(HeapTag tag, size_t size);
+
+/// @brief Resizes memory allocated with heap_stats_malloc, moving it to a tag
+/// @param tag Tag to count allocation towards
+/// @param ptr Memory to resize, NULL to allocate new memory
+/// @param size New size in bytes
+/// @return Pointer to resized memory, NULL if resizing failed (ptr is left untouched)
+void* heap_stats_realloc(HeapTag tag, void* ptr, size_t size);
+
+/// @brief Frees memory allocated with heap_stats_malloc or heap_stats_realloc
+/// @param ptr Memory to free
+void heap_stats_free(void* ptr);
+
+/// @brief Marks free heap before allocating memory the SDK owns, like windows or layers
+/// @return Mark to pass to heap_stats_account
+uint32_t heap_stats_mark();
+
+/// @brief Counts heap used or freed by the SDK since a mark towards a tag
+/// @param tag Tag to count towards
+/// @param mark Mark taken with heap_stats_mark
+void heap_stats_account(HeapTag tag, uint32_t mark);
+
+/// @brief Gets heap usage of a tag
+/// @param tag Tag to get usage of
+/// @return Pointer to usage stats of tag
+const HeapTagStats* heap_stats_get(HeapTag tag);
+
+/// @brief Gets a short display name of a tag
+/// @param tag Tag to get name of
+/// @return Name of tag
+const char* heap_stats_get_tag_name(HeapTag tag);
+
+/// @brief Gets the lowest free heap seen while allocating
+/// @return Lowest free heap in bytes
+uint32_t heap_stats_get_min_free();
+
+/// @brief Writes stats of every tag to the app log
+void heap_stats_log();
+
+#else
+
+#define heap_stats_malloc(tag, size) malloc(size)
+#define heap_stats_realloc(tag, ptr, size) realloc(ptr, size)
+#define heap_stats_free(ptr) free(ptr)
+#define heap_stats_mark() 0
+#define heap_stats_account(tag, mark) ((void)(mark))
+
+#endif
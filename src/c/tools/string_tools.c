@@ -1,4 +1,5 @@
 #include "string_tools.h"
+#include "heap_stats.h"
 #include <stdlib.h>
 
 char** string_split(const char* input, char delimiter, uint16_t* output_length) {
@@ -19,7 +20,7 @@ char** string_split(const char* input, char delimiter, uint16_t* output_length)
         i++;
     }
 
-    char** output = (char**)malloc(sizeof(char*) * arr_len);
+    char** output = (char**)heap_stats_malloc(HEAP_TAG_STRINGS, sizeof(char*) * arr_len);
 
     // iterate a second time, creating & copying substrings as we go
     uint16_t str_start_index = 0;
@@ -31,7 +32,7 @@ char** string_split(const char* input, char delimiter, uint16_t* output_length)
         }
 
         // allocate string and copy
-        output[i] = (char*)malloc(sizeof(char) * (str_len + 1));
+        output[i] = (char*)heap_stats_malloc(HEAP_TAG_STRINGS, sizeof(char) * (str_len + 1));
         strncpy(output[i], &input[str_start_index], str_len);
         output[i][str_len] = '\0';
 
@@ -49,11 +50,11 @@ char** string_split(const char* input, char delimiter, uint16_t* output_length)
 void string_array_free(char** string_array, uint16_t length) {
     for (uint16_t i = 0; i < length; i++) {
         if (string_array[i] != NULL) {
-            free(string_array[i]);
+            heap_stats_free(string_array[i]);
         }
     }
 
-    free(string_array);
+    heap_stats_free(string_array);
 }
 
 bool string_start_same(const char* a, const char* b) {
@@ -68,7 +69,27 @@ bool string_start_same(const char* a, const char* b) {
     return true;
 }
 
+size_t string_fit_length(const char* str, size_t max_length) {
+    size_t len = 0;
+    while (len < max_length && str[len] != '\0') {
+        len++;
+    }
+
+    // if the cut lands inside a multi-byte UTF-8 character, back up to
+    //   where it starts so half a character never gets drawn
+    if (str[len] != '\0') {
+        while (len > 0 && ((uint8_t)str[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+
+    return len;
+}
+
 void string_safe_copy(char* dest, const char* src, size_t size) {
-    strncpy(dest, src, size);
-    dest[size - 1] = '\0';
+    if (size == 0) return;
+
+    size_t len = string_fit_length(src, size - 1);
+    memcpy(dest, src, len);
+    dest[len] = '\0';
 }
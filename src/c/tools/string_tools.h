@@ -20,7 +20,14 @@ void string_array_free(char** string_array, uint16_t length);
 /// @return Whether or not strings start with the same characters
 bool string_start_same(const char* a, const char* b);
 
+/// @brief Gets how many bytes of a string fit in a length without cutting a UTF-8 character in half
+/// @param str String to measure
+/// @param max_length Most bytes that fit, not counting a null terminator
+/// @return Bytes of the string that fit
+size_t string_fit_length(const char* str, size_t max_length);
+
 /// @brief Copies a string to a potentially smaller sized destination, ensures a null terminator
+///        and only cuts between UTF-8 characters
 /// @param dest Pointer to destination string
 /// @param src Pointer to source string
 /// @param size Max size of destination to copy
@@ -0,0 +1,66 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+// one full sync is around 20 events, this keeps the last couple
+#define TRACE_CAPACITY 48
+
+static TraceEntry entries[TRACE_CAPACITY];
+static uint8_t next_entry = 0;
+static uint8_t num_entries = 0;
+
+static time_t start_seconds = 0;
+static bool first_draw_armed = true;
+
+// ms since the first event, plenty of range for a session
+static uint32_t get_time() {
+    time_t seconds = 0;
+    uint16_t ms = 0;
+    time_ms(&seconds, &ms);
+
+    if (start_seconds == 0) {
+        start_seconds = seconds;
+    }
+
+    return (uint32_t)(seconds - start_seconds) * 1000 + ms;
+}
+
+void trace_record(TraceEvent event, uint16_t arg) {
+    entries[next_entry] = (TraceEntry) {
+        .time = get_time(),
+        .arg = arg,
+        .event = event
+    };
+
+    next_entry = (next_entry + 1) % TRACE_CAPACITY;
+    if (num_entries < TRACE_CAPACITY) {
+        num_entries++;
+    }
+}
+
+void trace_arm_first_draw() {
+    first_draw_armed = true;
+}
+
+void trace_first_draw() {
+    if (!first_draw_armed) return;
+
+    first_draw_armed = false;
+    trace_record(TRACE_EVENT_FIRST_DRAW, 0);
+}
+
+uint8_t trace_copy(TraceEntry* out, uint8_t max) {
+    uint8_t count = num_entries < max ? num_entries : max;
+
+    // skip the oldest if there isn't room for all of them
+    uint8_t oldest = (next_entry + TRACE_CAPACITY - num_entries) % TRACE_CAPACITY;
+    uint8_t start = (oldest + (num_entries - count)) % TRACE_CAPACITY;
+
+    for (uint8_t i = 0; i < count; i++) {
+        out[i] = entries[(start + i) % TRACE_CAPACITY];
+    }
+
+    return count;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <pebble.h>
+
+// flip on to time the sync pipeline, events are kept in a small ring
+//   and can be dumped to the phone log from settings
+#define TRACE_ENABLED 0
+
+// make sure these match TRACE_EVENT_NAMES in index.ts
+/// @brief Points in the sync pipeline that get timestamped, args noted per event
+typedef enum {
+    TRACE_EVENT_INBOX_RECEIVED,             // streams in the message
+    TRACE_EVENT_PARSE_GROUPS_START,         // groups in batch
+    TRACE_EVENT_PARSE_GROUPS_END,
+    TRACE_EVENT_PARSE_FRONTABLES_START,     // frontables in batch
+    TRACE_EVENT_PARSE_FRONTABLES_END,
+    TRACE_EVENT_PARSE_CURRENT_FRONTS_START,
+    TRACE_EVENT_PARSE_CURRENT_FRONTS_END,
+    TRACE_EVENT_FLUSH_GROUPS_START,         // groups queued
+    TRACE_EVENT_FLUSH_GROUPS_END,
+    TRACE_EVENT_FLUSH_FRONTABLES_START,     // frontables queued
+    TRACE_EVENT_FLUSH_FRONTABLES_END,
+    TRACE_EVENT_FLUSH_CURRENT_FRONTS_START, // fronters queued
+    TRACE_EVENT_FLUSH_CURRENT_FRONTS_END,
+    TRACE_EVENT_MENUS_TEARDOWN_START,
+    TRACE_EVENT_MENUS_TEARDOWN_END,
+    TRACE_EVENT_MENUS_REBUILD_START,
+    TRACE_EVENT_MENUS_REBUILD_END,
+    TRACE_EVENT_PERSIST_LOAD_START,
+    TRACE_EVENT_PERSIST_LOAD_END,           // whether anything loaded
+    TRACE_EVENT_PERSIST_STORE_START,
+    TRACE_EVENT_PERSIST_STORE_END,          // bytes stored
+    TRACE_EVENT_FIRST_DRAW,
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+/// @brief A single timestamped event
+typedef struct {
+    uint32_t time;
+    uint16_t arg;
+    uint8_t event;
+} TraceEntry;
+
+#if TRACE_ENABLED
+
+/// @brief Records an event, overwriting the oldest once the ring is full
+/// @param event Event that happened
+/// @param arg Extra detail, meaning depends on the event
+void trace_record(TraceEvent event, uint16_t arg);
+
+/// @brief Makes the next trace_first_draw record, call whenever data lands that menus will show
+void trace_arm_first_draw();
+
+/// @brief Records the first draw after launch or trace_arm_first_draw, every later call does nothing
+void trace_first_draw();
+
+/// @brief Copies recorded events out of the ring, oldest first
+/// @param out Array to copy entries into
+/// @param max Max number of entries to copy
+/// @return Number of entries copied
+uint8_t trace_copy(TraceEntry* out, uint8_t max);
+
+#else
+
+#define trace_record(event, arg) ((void)(arg))
+#define trace_arm_first_draw() ((void)0)
+#define trace_first_draw() ((void)0)
+
+#endif
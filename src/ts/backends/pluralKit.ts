@@ -1,5 +1,6 @@
 import { APIImpl, ConfigLayout, Group } from "../types";
-import * as utils from "../utils";
+import { createScheduler } from "../scheduler";
+import { createRelayChannel } from "../push";
 
 const FETCH_URL = "https://api.pluralkit.me/v2/";
 const FETCH_TEMPLATE = Object.freeze({
@@ -9,6 +10,20 @@ const FETCH_TEMPLATE = Object.freeze({
     }
 });
 
+// published limits are 10/s for GETs and 3/s for everything else,
+//   kept a bit under both so timing jitter doesn't tip us over
+const scheduler = createScheduler({
+    readsPerSecond: 8,
+    writesPerSecond: 2,
+    burst: 5,
+    maxInFlight: 4,
+    timeoutMs: 15 * 1000,
+    maxRetries: 3,
+    // long enough to cover ready, a fetch request and the config
+    //   page closing all starting a sync at once
+    settleMs: 5 * 1000,
+});
+
 // === TYPES ==============================================
 
 interface MemberMessage {
@@ -33,10 +48,18 @@ interface SwitchMessage {
     members: string[] | MemberMessage[];
 }
 
+// what the relay forwards, the webhook payload as PK sends it
+interface WebhookMessage {
+    type: string;
+    system_id: string;
+}
+
 interface GroupMessage {
     uuid: string;
     name: string;
     color?: string;
+    // member uuids, only there when requested with "with_members"
+    members?: string[];
 }
 
 // === SIMPLE GET STUFF ===================================
@@ -44,7 +67,7 @@ interface GroupMessage {
 async function fetchGetUID() {
     console.log("hello freak");
 
-    const { jsonData } = await utils.fetch<SystemMessage>({
+    const { jsonData } = await scheduler.fetch<SystemMessage>({
         ...FETCH_TEMPLATE,
         url: FETCH_URL + "systems/@me",
         method: "GET"
@@ -54,7 +77,7 @@ async function fetchGetUID() {
 }
 
 async function fetchGetAllFrontables(uid: string) {
-    const { jsonData } = await utils.fetch<MemberMessage[]>({
+    const { jsonData } = await scheduler.fetch<MemberMessage[]>({
         ...FETCH_TEMPLATE,
         url: FETCH_URL + `systems/${uid}/members`,
         method: "GET"
@@ -70,13 +93,12 @@ async function fetchGetAllFrontables(uid: string) {
         pronouns: msg.pronouns,
         archived: false,
         apiUid: msg.uuid,
-        hash: utils.genHash(msg.uuid),
         isCustom: false
     }));
 }
 
 async function fetchGetCurrentFronters(uid: string) {
-    const { jsonData } = await utils.fetch<SwitchMessage>({
+    const { jsonData } = await scheduler.fetch<SwitchMessage>({
         ...FETCH_TEMPLATE,
         url: FETCH_URL + `systems/${uid}/fronters`,
         method: "GET"
@@ -93,7 +115,6 @@ async function fetchGetCurrentFronters(uid: string) {
 
         return {
             frontableApiUid: member.uuid,
-            frontableHash: utils.genHash(member.uuid),
             startTime: new Date(jsonData.timestamp).getTime(),
             // endTime: 0,
         };
@@ -101,9 +122,11 @@ async function fetchGetCurrentFronters(uid: string) {
 }
 
 async function fetchGetGroups(uid: string) {
-    const { jsonData } = await utils.fetch<GroupMessage[]>({
+    // members come inlined as uuids, so this is one request no matter
+    //   how many groups there are (a request per group trips rate limits)
+    const { jsonData } = await scheduler.fetch<GroupMessage[]>({
         ...FETCH_TEMPLATE,
-        url: FETCH_URL + `systems/${uid}/groups`,
+        url: FETCH_URL + `systems/${uid}/groups?with_members=true`,
         method: "GET"
     });
 
@@ -111,37 +134,19 @@ async function fetchGetGroups(uid: string) {
         return [];
     }
 
-    let groups: Group[] = [];
-
-    // for every found group, fetch their members 
-    //   (and async await for all of them to be done in parallel)
-    await Promise.all(jsonData.map(async (groupMsg) => {
-        const { jsonData } = await utils.fetch<MemberMessage[]>({
-            ...FETCH_TEMPLATE,
-            url: FETCH_URL + `groups/${groupMsg.uuid}/members`,
-            method: "GET"
-        });
-
-        if (jsonData) {
-            const group: Group = {
-                id: groupMsg.uuid,
-                name: groupMsg.name,
-                color: groupMsg.color,
-                parent: "",
-                memberHashes: jsonData.map(m => utils.genHash(m.uuid)),
-            };
-
-            groups.push(group);
-        }
+    return jsonData.map((groupMsg): Group => ({
+        id: groupMsg.uuid,
+        name: groupMsg.name,
+        color: groupMsg.color,
+        parent: "",
+        memberUids: groupMsg.members ?? [],
     }));
-
-    return groups;
 }
 
 // === POST STUFF =========================================
 
 async function fetchSetCurrentFronters(uid: string, toAddApiUids: string[]) {
-    const { jsonData } = await utils.fetch<SwitchMessage>({
+    const { jsonData } = await scheduler.fetch<SwitchMessage>({
         ...FETCH_TEMPLATE,
         url: FETCH_URL + `systems/${uid}/switches`,
         method: "POST",
@@ -158,7 +163,6 @@ async function fetchSetCurrentFronters(uid: string, toAddApiUids: string[]) {
 
     return members.map(m => ({
         frontableApiUid: m.uuid,
-        frontableHash: utils.genHash(m.uuid),
         startTime: new Date(jsonData.timestamp).getTime(),
     }));
 }
@@ -170,9 +174,31 @@ const CONFIG_LAYOUT: ConfigLayout = Object.freeze({
         label: "PluralKit Token - REQUIRED FOR APP TO WORK!",
         description: "Can be found with the [[ <em>pk;token</em> ]] command!"
     },
+    additionalItems: [
+        {
+            type: "input",
+            messageKey: "PushRelayUrl",
+            label: "Push Relay URL (optional)",
+            description: "A websocket relay forwarding your system's PluralKit webhooks, fronters update instantly instead of on refresh. Leave empty to turn off!",
+        },
+    ],
 });
 
-// TODO: figure out PK webhooks? you can use them to get similar functionality to a socket
+// === PUSH STUFF =========================================
+
+// PK can only push through webhooks, which need a server, so events
+//   come in through a relay that forwards them over a websocket
+const SWITCH_EVENTS = ["CREATE_SWITCH", "UPDATE_SWITCH", "DELETE_SWITCH", "DELETE_ALL_SWITCHES"];
+
+const push = createRelayChannel((event: WebhookMessage, uid: string) => {
+    if (event.system_id !== uid || SWITCH_EVENTS.indexOf(event.type) < 0) {
+        return false;
+    }
+
+    // anything fetched before this switch is out of date now
+    scheduler.invalidate();
+    return true;
+});
 
 // === IMPL ASSEMBLING ====================================
 
@@ -186,7 +212,9 @@ const IMPL: APIImpl = Object.freeze({
         fetchGetGroups,
         fetchSetCurrentFronters,
     },
+    push,
     configLayout: CONFIG_LAYOUT,
+    logRequestStats: scheduler.logStats,
 });
 
 export default IMPL;
@@ -1,5 +1,7 @@
-import { Frontable, FrontEntry, Group } from "./types";
+import { DataLimits, Frontable, FrontEntry, Group, Member, MemoryLevel, PendingSwitch } from "./types";
+import type { DatasetSchedule } from "./refresh";
 import * as sorting from "./sorting";
+import * as messaging from "./messaging";
 
 enum CacheKeys {
     Frontables = "cachedFrontables",
@@ -8,42 +10,235 @@ enum CacheKeys {
     SystemId = "cachedSystemId",
     CurrentFronts = "cachedCurrentFrontMessages",
     AppVersion = "cachedAppVersion",
+    // replaced by RefreshSchedule, kept so clearing still removes it
     PrevFetchTime = "cachedPrevFetchTime",
     FetchInterval = "cachedFetchInterval",
     Backend = "cachedBackend",
+    SchemaVersion = "cachedSchemaVersion",
+    FrontableIds = "cachedFrontableIds",
+    DataRevision = "cachedDataRevision",
+    DataLimits = "cachedDataLimits",
+    PushRelayUrl = "cachedPushRelayUrl",
+    PendingSwitch = "cachedPendingSwitch",
+    RefreshSchedule = "cachedRefreshSchedule",
 }
 
-export function cacheFrontables(frontables: Frontable[]) {
-    localStorage.setItem(CacheKeys.Frontables, JSON.stringify(frontables));
+// bump this whenever the shape of anything stored in localStorage changes,
+//   and add a migration from the previous version to MIGRATIONS below
+const SCHEMA_VERSION = 2;
+
+// MIGRATIONS[n] upgrades stored data from schema n to n + 1,
+//   null means the two are truly incompatible and data must be re-fetched
+const MIGRATIONS: ((() => void) | null)[] = [
+    // 0 -> 1: schema versioning introduced, nothing else changed shape
+    () => { },
+    // 1 -> 2: hashes replaced by uuids here and by dense ids on the watch
+    migrateHashesToIds,
+];
+
+// keys holding fetched data that can always be fetched again,
+//   everything else is user setup that should survive upgrades
+const DATA_KEYS = [
+    CacheKeys.Frontables,
+    CacheKeys.Groups,
+    CacheKeys.CurrentFronts,
+    CacheKeys.PrevFetchTime,
+    CacheKeys.FrontableIds,
+    CacheKeys.RefreshSchedule,
+];
+
+// ~~~ in-memory store ~~~
+//
+// the big blobs are parsed once and kept here, reads never go back to
+//   localStorage and every write goes through to it so the next launch
+//   still finds them. undefined means not loaded yet, null means nothing
+//   is stored. getters hand out copies of the arrays since messaging
+//   splices whatever it's given into batches
+
+let storedFrontables: Frontable[] | null | undefined;
+let frontablesByUid: { [apiUid: string]: Frontable } = {};
+// index is the id the watch knows a frontable by, value is its uuid
+let storedFrontableIds: string[] | null | undefined;
+let storedGroups: Group[] | null | undefined;
+let storedCurrentFronts: FrontEntry[] | null | undefined;
+let frontingUids: { [apiUid: string]: boolean } = {};
+
+function readStored<T>(key: CacheKeys): T | null {
+    const str = localStorage.getItem(key);
+    return str ? JSON.parse(str) as T : null;
+}
+
+function setStoredFrontables(frontables: Frontable[] | null) {
+    storedFrontables = frontables;
+    frontablesByUid = {};
+    for (const frontable of frontables ?? []) {
+        frontablesByUid[frontable.apiUid] = frontable;
+    }
+}
+
+function setStoredCurrentFronts(entries: FrontEntry[] | null) {
+    storedCurrentFronts = entries;
+    frontingUids = {};
+    for (const entry of entries ?? []) {
+        frontingUids[entry.frontableApiUid] = true;
+    }
+}
+
+function loadFrontables(): Frontable[] | null {
+    if (storedFrontables === undefined) {
+        setStoredFrontables(readStored<Frontable[]>(CacheKeys.Frontables));
+    }
+
+    return storedFrontables ?? null;
+}
+
+function loadFrontableIds(): string[] | null {
+    if (storedFrontableIds === undefined) {
+        storedFrontableIds = readStored<string[]>(CacheKeys.FrontableIds);
+    }
+
+    return storedFrontableIds;
+}
+
+function loadGroups(): Group[] | null {
+    if (storedGroups === undefined) {
+        storedGroups = readStored<Group[]>(CacheKeys.Groups);
+    }
+
+    return storedGroups;
+}
+
+function loadCurrentFronts(): FrontEntry[] | null {
+    if (storedCurrentFronts === undefined) {
+        setStoredCurrentFronts(readStored<FrontEntry[]>(CacheKeys.CurrentFronts));
+    }
+
+    return storedCurrentFronts ?? null;
+}
+
+/**
+ * Parses everything stored into memory up front, so the first watch
+ *   request after launch doesn't pay for it
+ */
+export function loadStore() {
+    loadFrontables();
+    loadFrontableIds();
+    loadGroups();
+    loadCurrentFronts();
+}
+
+// next read goes back to localStorage, for anything that touched it directly
+function resetStore() {
+    storedFrontables = undefined;
+    frontablesByUid = {};
+    storedFrontableIds = undefined;
+    storedGroups = undefined;
+    storedCurrentFronts = undefined;
+    frontingUids = {};
+}
+
+// ~~~ stored data ~~~
+
+// true if what's stored under a key changed, the watch only needs
+//   a new revision when it did
+function storeIfChanged(key: CacheKeys, value: any): boolean {
+    const str = JSON.stringify(value);
+    if (localStorage.getItem(key) === str) {
+        return false;
+    }
+
+    localStorage.setItem(key, str);
+    return true;
+}
+
+/**
+ * @returns true if the frontables differed from what was cached
+ */
+export function cacheFrontables(frontables: Frontable[]): boolean {
+    setStoredFrontables(frontables.slice());
+    if (!storeIfChanged(CacheKeys.Frontables, frontables)) {
+        return false;
+    }
+
+    bumpDataRevision();
+    return true;
 }
 
 export function getAllFrontables(): Frontable[] | null {
-    const cachedFrontablesStr = localStorage.getItem(CacheKeys.Frontables);
-    if (cachedFrontablesStr) {
-        const frontables = JSON.parse(cachedFrontablesStr) as Frontable[];
-        return frontables;
+    return loadFrontables()?.slice() ?? null;
+}
+
+export function getFrontableById(id: number): Frontable | null {
+    const apiUid = loadFrontableIds()?.[id];
+    if (apiUid === undefined) {
+        return null;
     }
 
-    return null;
+    loadFrontables();
+    return frontablesByUid[apiUid] ?? null;
 }
 
-export function getFrontable(hash: number): Frontable | null {
-    const frontables = getAllFrontables();
-    return frontables?.find(f => f.hash === hash) ?? null;
+export function getFrontableByUid(apiUid: string): Frontable | null {
+    loadFrontables();
+    return frontablesByUid[apiUid] ?? null;
 }
 
-export function cacheGroups(groups: Group[]) {
-    localStorage.setItem(CacheKeys.Groups, JSON.stringify(groups));
+export function getFrontableIds(): string[] | null {
+    return loadFrontableIds()?.slice() ?? null;
 }
 
-export function getAllGroups(): Group[] | null {
-    const cachedGroupsStr = localStorage.getItem(CacheKeys.Groups);
-    if (cachedGroupsStr) {
-        const groups = JSON.parse(cachedGroupsStr) as Group[];
-        return groups;
+export function cacheFrontableIds(ids: string[]) {
+    localStorage.setItem(CacheKeys.FrontableIds, JSON.stringify(ids));
+    storedFrontableIds = ids.slice();
+}
+
+/**
+ * @returns true if the groups differed from what was cached
+ */
+export function cacheGroups(groups: Group[]): boolean {
+    storedGroups = groups.slice();
+    if (!storeIfChanged(CacheKeys.Groups, groups)) {
+        return false;
     }
 
-    return null;
+    bumpDataRevision();
+    return true;
+}
+
+// counts every change to cached frontables/groups, the watch echoes
+//   back the last one it got so reconnects only re-send when it's behind.
+//   never 0, that's what the watch sends when it has nothing
+export function getDataRevision(): number {
+    const revision = localStorage.getItem(CacheKeys.DataRevision);
+    if (revision) {
+        return Number(revision);
+    }
+
+    return 1;
+}
+
+function bumpDataRevision() {
+    // wraps well before the watch's uint32 would
+    const next = (getDataRevision() % 0x7FFFFFFF) + 1;
+    localStorage.setItem(CacheKeys.DataRevision, next.toString());
+}
+
+// full data until the watch says it couldn't fit it
+export function getDataLimits(): DataLimits {
+    const cachedLimitsStr = localStorage.getItem(CacheKeys.DataLimits);
+    if (cachedLimitsStr) {
+        return JSON.parse(cachedLimitsStr);
+    }
+
+    return { level: MemoryLevel.Normal, maxFrontables: 0xFFFF };
+}
+
+export function cacheDataLimits(limits: DataLimits) {
+    localStorage.setItem(CacheKeys.DataLimits, JSON.stringify(limits));
+}
+
+export function getAllGroups(): Group[] | null {
+    return loadGroups()?.slice() ?? null;
 }
 
 export function getApiToken(): string | null {
@@ -63,25 +258,21 @@ export function cacheSystemId(id: string) {
 }
 
 export function getCurrentFronts(): FrontEntry[] | null {
-    const cachedFronts = localStorage.getItem(CacheKeys.CurrentFronts);
-    if (cachedFronts) {
-        return JSON.parse(cachedFronts) as FrontEntry[];
-    }
-
-    return null;
+    return loadCurrentFronts()?.slice() ?? null;
 }
 
 export function cacheCurrentFronts(entries: FrontEntry[]) {
     localStorage.setItem(CacheKeys.CurrentFronts, JSON.stringify(entries));
+    setStoredCurrentFronts(entries.slice());
 }
 
 export function addFrontToCache(entry: FrontEntry) {
-    console.log(`adding ${entry.frontableHash} to front cache...`);
+    console.log(`adding ${entry.frontableApiUid} to front cache...`);
 
     let currentFronts = getCurrentFronts();
     if (currentFronts) {
         // only add fronts if they don't already exist
-        if (!currentFronts.find(f => f.frontableHash === entry.frontableHash)) {
+        if (!frontingUids[entry.frontableApiUid]) {
             currentFronts.push(entry);
         }
     } else {
@@ -94,12 +285,12 @@ export function addFrontToCache(entry: FrontEntry) {
 }
 
 export function removeFrontFromCache(entry: FrontEntry) {
-    console.log(`removing ${entry.frontableHash} from front cache...`);
+    console.log(`removing ${entry.frontableApiUid} from front cache...`);
 
     let currentFronts = getCurrentFronts();
     if (currentFronts) {
         // only remove fronts if they exist
-        const idx = currentFronts.findIndex(f => f.frontableHash === entry.frontableHash);
+        const idx = currentFronts.findIndex(f => f.frontableApiUid === entry.frontableApiUid);
         if (idx >= 0) {
             currentFronts.splice(idx, 1);
         }
@@ -112,14 +303,14 @@ export function removeFrontFromCache(entry: FrontEntry) {
     cacheCurrentFronts(currentFronts);
 }
 
-export function removeFrontFromCacheViaHash(hash: number): FrontEntry | null {
-    console.log(`removing ${hash} from front cache...`);
+export function removeFrontFromCacheViaUid(apiUid: string): FrontEntry | null {
+    console.log(`removing ${apiUid} from front cache...`);
 
     let currentFronts = getCurrentFronts();
     let message: FrontEntry | null = null;
     if (currentFronts) {
         // only remove fronts if they exist
-        const idx = currentFronts.findIndex(f => f.frontableHash === hash);
+        const idx = currentFronts.findIndex(f => f.frontableApiUid === apiUid);
         if (idx >= 0) {
             [message] = currentFronts.splice(idx, 1);
         }
@@ -134,14 +325,33 @@ export function removeFrontFromCacheViaHash(hash: number): FrontEntry | null {
 }
 
 export function isFronting(frontable: Frontable): boolean {
-    const currentFrontMessages = getCurrentFronts();
-    if (currentFrontMessages) {
-        // "!!" turns this into a boolean lol
-        //   (it's a double boolean NOT lol)
-        return !!currentFrontMessages.find(m => m.frontableHash === frontable.hash);
+    loadCurrentFronts();
+    return frontingUids[frontable.apiUid] === true;
+}
+
+// outbound switch queue, coalesced down to the latest one since that's
+//   the only front anyone still wants. persisted so a switch made
+//   offline survives the app closing
+export function getPendingSwitch(): PendingSwitch | null {
+    const pending = localStorage.getItem(CacheKeys.PendingSwitch);
+    if (pending) {
+        return JSON.parse(pending) as PendingSwitch;
     }
 
-    return false;
+    return null;
+}
+
+export function queueSwitch(apiUids: string[]): PendingSwitch {
+    const pending: PendingSwitch = { apiUids, time: Date.now() };
+    localStorage.setItem(CacheKeys.PendingSwitch, JSON.stringify(pending));
+    return pending;
+}
+
+// only clears the switch that was actually sent, not one queued since
+export function clearPendingSwitch(sent: PendingSwitch) {
+    if (getPendingSwitch()?.time === sent.time) {
+        localStorage.removeItem(CacheKeys.PendingSwitch);
+    }
 }
 
 export function getAppVersion(): string | null {
@@ -152,17 +362,17 @@ export function cacheAppVersion(version: string) {
     localStorage.setItem(CacheKeys.AppVersion, version);
 }
 
-export function getPrevFetchTime(): number | null {
-    const time = localStorage.getItem(CacheKeys.PrevFetchTime);
-    if (time) {
-        return Number(time);
+export function getRefreshSchedule(): { [dataset: string]: DatasetSchedule } {
+    const schedule = localStorage.getItem(CacheKeys.RefreshSchedule);
+    if (schedule) {
+        return JSON.parse(schedule);
     }
 
-    return null;
+    return {};
 }
 
-export function cachePrevFetchTime(time: number) {
-    localStorage.setItem(CacheKeys.PrevFetchTime, time.toString());
+export function cacheRefreshSchedule(schedule: { [dataset: string]: DatasetSchedule }) {
+    localStorage.setItem(CacheKeys.RefreshSchedule, JSON.stringify(schedule));
 }
 
 export function getFetchInterval(): number | null {
@@ -178,6 +388,14 @@ export function cacheFetchInterval(interval: number) {
     localStorage.setItem(CacheKeys.FetchInterval, interval.toString());
 }
 
+export function getPushRelayUrl(): string | null {
+    return localStorage.getItem(CacheKeys.PushRelayUrl);
+}
+
+export function cachePushRelayUrl(url: string) {
+    localStorage.setItem(CacheKeys.PushRelayUrl, url);
+}
+
 export function getBackend(): string | null {
     return localStorage.getItem(CacheKeys.Backend);
 }
@@ -187,7 +405,102 @@ export function cacheBackend(backend: string) {
 }
 
 export function clearAllCache() {
+    // for..in gives enum member names, look up the actual storage keys
     for (const key in CacheKeys) {
+        localStorage.removeItem(CacheKeys[key as keyof typeof CacheKeys]);
+    }
+
+    resetStore();
+}
+
+export function clearDataCache() {
+    for (const key of DATA_KEYS) {
         localStorage.removeItem(key);
     }
+
+    resetStore();
+}
+
+function migrateHashesToIds() {
+    const frontables = getAllFrontables() as (Frontable & { hash?: number })[] | null;
+    if (!frontables) {
+        // nothing to map member hashes back to, let groups be fetched again
+        localStorage.removeItem(CacheKeys.Groups);
+        storedGroups = null;
+        return;
+    }
+
+    const uidsByHash: { [hash: number]: string } = {};
+    for (const frontable of frontables) {
+        if (frontable.hash !== undefined) {
+            uidsByHash[frontable.hash] = frontable.apiUid;
+            delete frontable.hash;
+        }
+    }
+    cacheFrontables(frontables);
+
+    const groups = getAllGroups() as (Group & { memberHashes?: number[] })[] | null;
+    if (groups) {
+        for (const group of groups) {
+            group.memberUids = (group.memberHashes ?? [])
+                .map(hash => uidsByHash[hash])
+                .filter(uid => uid !== undefined);
+            delete group.memberHashes;
+        }
+        cacheGroups(groups);
+    }
+
+    const currentFronts = getCurrentFronts() as (FrontEntry & { frontableHash?: number })[] | null;
+    if (currentFronts) {
+        currentFronts.forEach(entry => delete entry.frontableHash);
+        cacheCurrentFronts(currentFronts);
+    }
+
+    // the watch turns its cached hashes into send positions the same way
+    const sent = frontables.filter(f => !((f as Member).archived));
+    cacheFrontableIds(messaging.getFrontableIdMap(sent));
+}
+
+function getSchemaVersion(): number | null {
+    const schemaVersion = localStorage.getItem(CacheKeys.SchemaVersion);
+    if (schemaVersion) {
+        return Number(schemaVersion);
+    }
+
+    // installs from before schema versions existed still have an app version
+    return getAppVersion() ? 0 : null;
+}
+
+/**
+ * Upgrades stored data to the current schema, one migration at a time
+ * @returns false if stored data was incompatible and had to be cleared
+ */
+export function migrateSchema(): boolean {
+    let schemaVersion = getSchemaVersion();
+    let compatible = true;
+
+    if (schemaVersion !== null && schemaVersion > SCHEMA_VERSION) {
+        // downgrades can't be migrated, don't guess at a newer layout
+        compatible = false;
+    }
+
+    while (compatible && schemaVersion !== null && schemaVersion < SCHEMA_VERSION) {
+        const migration = MIGRATIONS[schemaVersion];
+        if (!migration) {
+            compatible = false;
+            break;
+        }
+
+        console.log(`migrating cache schema ${schemaVersion} -> ${schemaVersion + 1}...`);
+        migration();
+        schemaVersion++;
+    }
+
+    if (!compatible) {
+        clearDataCache();
+    }
+
+    localStorage.setItem(CacheKeys.SchemaVersion, SCHEMA_VERSION.toString());
+
+    return compatible;
 }
@@ -2,11 +2,32 @@ import * as cache from "./cache";
 import * as messaging from "./messaging";
 import * as sorting from "./sorting";
 import * as config from "./config";
+import * as utils from "./utils";
+import * as refresh from "./refresh";
 import { Member, AppMessageDesc, Frontable, Group, FrontEntry, APIImpl } from "./types";
 import { version } from "../../package.json";
 
 const clay = config.init();
 
+// make sure these match the HeapTag enum in heap_stats.h
+const HEAP_TAG_NAMES = ["Frontables", "Lists", "Groups", "Cache", "Queues", "Messaging", "Strings", "Menus"];
+
+// make sure these match the TraceEvent enum in trace.h
+const TRACE_EVENT_NAMES = [
+    "inbox received",
+    "parse groups start", "parse groups end",
+    "parse frontables start", "parse frontables end",
+    "parse current fronts start", "parse current fronts end",
+    "flush groups start", "flush groups end",
+    "flush frontables start", "flush frontables end",
+    "flush current fronts start", "flush current fronts end",
+    "menus teardown start", "menus teardown end",
+    "menus rebuild start", "menus rebuild end",
+    "persist load start", "persist load end",
+    "persist store start", "persist store end",
+    "first draw",
+];
+
 async function setupApi(backend: APIImpl, token: string) {
     console.log("setting up API and socket...");
 
@@ -53,7 +74,7 @@ async function fetchFrontables(backend: APIImpl, uid: string, useCache: boolean,
 
             frontables = await backend.endpoints.fetchGetAllFrontables(uid);
             frontables = sorting.sortFrontables(frontables);
-            cache.cacheFrontables(frontables);
+            refresh.recordFetch(refresh.Dataset.Frontables, cache.cacheFrontables(frontables));
 
             console.log("Frontables fetched, assembled, and cached!");
 
@@ -103,7 +124,7 @@ async function fetchGroups(backend: APIImpl, uid: string, useCache: boolean): Pr
                 console.warn("WARNING: Frontables not found in cache, groups remain unsorted!");
             }
 
-            cache.cacheGroups(groups);
+            refresh.recordFetch(refresh.Dataset.Groups, cache.cacheGroups(groups));
 
             console.log("Groups fetched, assembled, and cached!");
 
@@ -117,8 +138,14 @@ async function fetchGroups(backend: APIImpl, uid: string, useCache: boolean): Pr
     return groups;
 }
 
-async function fetchAndSendAllData(backend: APIImpl, uid: string, useCache: boolean) {
-    const groupPromise = fetchGroups(backend, uid, useCache);
+interface SyncData {
+    frontables: Frontable[];
+    currentFronters: FrontEntry[];
+    groups: Group[];
+}
+
+async function fetchAllData(backend: APIImpl, uid: string, useCache: refresh.CachePolicy): Promise<SyncData> {
+    const groupPromise = fetchGroups(backend, uid, useCache.groups);
 
     let frontables: Frontable[] = [];
     let currentFronters: FrontEntry[] = [];
@@ -128,7 +155,7 @@ async function fetchAndSendAllData(backend: APIImpl, uid: string, useCache: bool
         groupPromise.then(g => {
             groups = g;
         }),
-        fetchFrontables(backend, uid, useCache, groupPromise).then(f => {
+        fetchFrontables(backend, uid, useCache.frontables, groupPromise).then(f => {
             frontables = f.filter(frontable => {
                 return !((frontable as Member).archived);
             });
@@ -138,22 +165,199 @@ async function fetchAndSendAllData(backend: APIImpl, uid: string, useCache: bool
         }),
     ]);
 
-    await messaging.sendDataBatchToWatch(frontables, currentFronters, groups);
+    backend.logRequestStats?.();
+
+    return { frontables, currentFronters, groups };
+}
+
+async function sendAllData({ frontables, currentFronters, groups }: SyncData) {
+    // ids are positions in the sorted list, so they're assigned per sync
+    const limits = cache.getDataLimits();
+    const idMap = messaging.getFrontableIdMap(frontables, limits);
+
+    await messaging.sendDataBatchToWatch(frontables, currentFronters, groups, idMap, cache.getDataRevision(), limits);
+
+    // the watch only swaps lists once the last message of the batch is in,
+    //   until then (or if the batch fails) its requests still use the old ids
+    cache.cacheFrontableIds(idMap);
+}
+
+async function fetchAndSendAllData(backend: APIImpl, uid: string, useCache: refresh.CachePolicy) {
+    await sendAllData(await fetchAllData(backend, uid, useCache));
+}
+
+// sends whatever is cached without touching the network,
+//   false if there wasn't a full set of data to send
+async function sendCachedData(): Promise<boolean> {
+    const frontables = cache.getAllFrontables();
+    const groups = cache.getAllGroups();
+    if (!frontables || !groups) {
+        return false;
+    }
+
+    await sendAllData({
+        frontables: frontables.filter(frontable => !((frontable as Member).archived)),
+        currentFronters: cache.getCurrentFronts() ?? [],
+        groups,
+    });
+
+    return true;
+}
+
+// checks the api after cached data was already sent, the watch only
+//   gets sent the parts that actually changed. caching only bumps the
+//   data revision when something's different, so that's what tells
+async function revalidateData(backend: APIImpl, uid: string, useCache: refresh.CachePolicy) {
+    const revision = cache.getDataRevision();
+    const prevFronts = JSON.stringify(cache.getCurrentFronts() ?? []);
+
+    const data = await fetchAllData(backend, uid, useCache);
+
+    if (cache.getDataRevision() !== revision) {
+        console.log("Revalidated data changed, re-sending everything...");
+        await sendAllData(data);
+    } else if (JSON.stringify(data.currentFronters) !== prevFronts) {
+        console.log("Revalidated fronters changed, only sending fronters...");
+        await messaging.sendCurrentFrontersToWatch(data.currentFronters, cache.getFrontableIds() ?? []);
+    } else {
+        console.log("Revalidated data is unchanged, nothing to send!");
+    }
 }
 
 // ~~~ init functions ~~~
 
 function initVersionWithCache() {
-    // check app version, clear cache across versions!
+    // migrate stored data forward rather than wiping it across versions,
+    //   only data that truly can't be upgraded gets fetched again
+    if (!cache.migrateSchema()) {
+        console.log("Cached data is incompatible with this version! It will be fetched again...");
+    }
+
     const cachedVersion = cache.getAppVersion();
-    if (!cachedVersion || cachedVersion !== version) {
-        console.log(`New version "${version}" detected! Clearing all app cache...`);
-        cache.clearAllCache();
+    if (cachedVersion !== version) {
+        console.log(`New version "${version}" detected!`);
         cache.cacheAppVersion(version);
-        messaging.sendApiKeyIsValid(false);
     }
 }
 
+// ~~~ outbound switches ~~~
+
+// how often a switch that couldn't be sent gets tried again
+const SWITCH_RETRY_MS = 30 * 1000;
+
+let switchReplay: Promise<void> | null = null;
+let switchRetryTimer: ReturnType<typeof setTimeout> | null = null;
+
+// server start times of switches posted from here, those never count
+//   as newer switches from somewhere else. only the latest few matter
+const OWN_SWITCH_TIMES_MAX = 8;
+const ownSwitchTimes: number[] = [];
+
+function recordOwnSwitch(entries: FrontEntry[]) {
+    for (const entry of entries) {
+        if (entry.startTime !== undefined && ownSwitchTimes.indexOf(entry.startTime) < 0) {
+            ownSwitchTimes.push(entry.startTime);
+        }
+    }
+
+    ownSwitchTimes.splice(0, Math.max(0, ownSwitchTimes.length - OWN_SWITCH_TIMES_MAX));
+}
+
+function sameFronters(a: string[], b: string[]): boolean {
+    return a.length === b.length && a.every(uid => b.indexOf(uid) >= 0);
+}
+
+async function sendPendingSwitch(backend: APIImpl) {
+    const uid = cache.getSystemId();
+    let pending = cache.getPendingSwitch();
+
+    while (uid && pending) {
+        // reconcile first, the server might already have this front
+        //   or a newer switch from somewhere else that shouldn't be undone
+        const serverFronts = await fetchAndSendCurrentFronts(backend, uid);
+        const serverUids = serverFronts.map(e => e.frontableApiUid);
+        const lastSwitchTime = Math.max(0, ...serverFronts
+            .map(e => e.startTime ?? 0)
+            .filter(time => ownSwitchTimes.indexOf(time) < 0));
+
+        let entries: FrontEntry[] | undefined = serverFronts;
+        if (sameFronters(serverUids, pending.apiUids)) {
+            console.log("Queued switch already matches the server, dropping it!");
+        } else if (lastSwitchTime > pending.time) {
+            console.log("Server has a newer switch than the queued one, dropping it!");
+        } else {
+            entries = await backend.endpoints.fetchSetCurrentFronters(uid, pending.apiUids);
+            if (entries !== undefined) {
+                recordOwnSwitch(entries);
+            }
+        }
+
+        cache.clearPendingSwitch(pending);
+
+        if (entries !== undefined) {
+            cache.cacheCurrentFronts(entries);
+            await messaging.sendCurrentFrontersToWatch(entries, cache.getFrontableIds() ?? []);
+        } else {
+            console.warn("WARNING: backend set fronters replied with undefined!!");
+        }
+
+        // another switch could've been queued while this one was out
+        pending = cache.getPendingSwitch();
+    }
+}
+
+// sends whatever switch is queued, safe to call from anywhere since
+//   only one replay runs at a time and failures retry on a timer
+function replayPendingSwitch(backend: APIImpl): Promise<void> {
+    if (switchReplay) {
+        return switchReplay;
+    }
+
+    if (switchRetryTimer !== null) {
+        clearTimeout(switchRetryTimer);
+        switchRetryTimer = null;
+    }
+
+    switchReplay = sendPendingSwitch(backend)
+        .catch(err => {
+            console.warn(`WARNING: couldn't send queued switch, retrying in ${SWITCH_RETRY_MS}ms! err: "${err}"`);
+            switchRetryTimer = setTimeout(() => {
+                switchRetryTimer = null;
+                replayPendingSwitch(backend);
+            }, SWITCH_RETRY_MS);
+        })
+        .then(() => {
+            switchReplay = null;
+        });
+
+    return switchReplay;
+}
+
+// fronters get pushed while this is connected, anything that
+//   changes the relay, token or system has to call it again
+function initPushChannel(backend: APIImpl) {
+    const uid = cache.getSystemId();
+    if (!backend.push || !uid) {
+        return;
+    }
+
+    backend.push.connect(uid, cache.getPushRelayUrl(), {
+        onFrontersChanged: async () => {
+            console.log("Push relay says fronters changed, fetching them...");
+
+            const prevFronts = JSON.stringify(cache.getCurrentFronts() ?? []);
+            try {
+                const entries = await fetchAndSendCurrentFronts(backend, uid);
+                if (JSON.stringify(entries) !== prevFronts) {
+                    await messaging.sendCurrentFrontersToWatch(entries, cache.getFrontableIds() ?? []);
+                }
+            } catch (err) {
+                console.error(`ERROR: fetching pushed fronters failed! err: "${err}"`);
+            }
+        },
+    });
+}
+
 async function initApiWithCache(backend: APIImpl) {
     // try to get cached api token
     const token = cache.getApiToken();
@@ -165,29 +369,13 @@ async function initApiWithCache(backend: APIImpl) {
     }
 }
 
-function initFetchIntervalCache() {
-    let fetchInterval = cache.getFetchInterval();
-    if (!fetchInterval) {
-        // (24h in MS is a fallback)
-        fetchInterval = (1000 * 60 * 60) * 24;
-    }
-
-    const prevFetchTime = cache.getPrevFetchTime();
-    const timeNow = Date.now();
-
-    let useCache = true;
-    if (!prevFetchTime || timeNow - prevFetchTime >= fetchInterval) {
-        console.log("Time since last fetch exceeded interval, clearing and re-fetching!");
-        useCache = false;
-        cache.cachePrevFetchTime(timeNow);
-    }
-
-    return useCache;
-}
-
-async function initSendInitialFetch(backend: APIImpl, uid: string, useCache: boolean) {
+async function initSendInitialFetch(backend: APIImpl, uid: string, useCache: refresh.CachePolicy, sentCache: boolean) {
     try {
-        await fetchAndSendAllData(backend, uid, useCache);
+        if (sentCache) {
+            await revalidateData(backend, uid, useCache);
+        } else {
+            await fetchAndSendAllData(backend, uid, useCache);
+        }
     } catch (err) {
         console.error(`ERROR: fetchAndSendAllData failed from ready event! err: "${err}"`);
         await messaging.sendErrorMessage("Unknown fetch error!");
@@ -198,10 +386,23 @@ async function initSendInitialFetch(backend: APIImpl, uid: string, useCache: boo
 
 Pebble.addEventListener("ready", async (e) => {
     initVersionWithCache();
+    cache.loadStore();
 
     const backend = config.getCurrentBackend();
 
+    // stale-while-revalidate, the watch gets cached data right away
+    //   while the api gets set up, then only what changed after that
+    const cachedSend = sendCachedData().catch(err => {
+        console.error(`ERROR: sending cached data failed from ready event! err: "${err}"`);
+        return false;
+    });
+
     await initApiWithCache(backend);
+    initPushChannel(backend);
+    const sentCache = await cachedSend;
+
+    // switches made while offline go out before anything is revalidated
+    await replayPendingSwitch(backend);
 
     // try to get cached uid
     const uid = cache.getSystemId();
@@ -210,8 +411,9 @@ Pebble.addEventListener("ready", async (e) => {
         return;
     }
 
-    const useCache = initFetchIntervalCache();
-    await initSendInitialFetch(backend, uid, useCache);
+    // fronters are always fetched, members and groups only when due
+    const useCache = refresh.getScheduledPolicy();
+    await initSendInitialFetch(backend, uid, useCache, sentCache);
 
     console.log("hey! app finished fetching and sending things! :)");
 });
@@ -222,57 +424,56 @@ Pebble.addEventListener("appmessage", async (e) => {
     const msg: AppMessageDesc = e.payload;
     const backend = config.getCurrentBackend();
 
-    const convertHash = (msgHash: number) => msgHash + Math.floor(0xFFFFFFFF / 2);
-
-    let currentFronterUids = cache.getCurrentFronts()
-        ?.map(e => e.frontableApiUid) || [];
+    // a queued switch is what the watch thinks is fronting,
+    //   so changes build on that rather than the last known server state
+    let currentFronterUids = cache.getPendingSwitch()?.apiUids
+        ?? cache.getCurrentFronts()?.map(e => e.frontableApiUid)
+        ?? [];
     let frontersModified = false;
 
-    // TODO: replace the three separate 
-    //   "AddFrontRequest", "SetFrontRequest", and "RemoveFrontRequest" 
-    //   messages keys with a single "set front request" that sets
-    //   a new array of hashes as the current fronters
-    //   (determined and calculated on the watch rather than on the ts)
+    // TODO: multi-select and group fronting already send the whole list
+    //   with "SetFrontListRequest", move the single-id
+    //   "AddFrontRequest", "SetFrontRequest", and "RemoveFrontRequest"
+    //   onto it too once the watch's current fronters can account for
+    //   a switch that's still queued here
 
-    if (msg.AddFrontRequest) {
-        // re-offset hash to ensure full unsigned range
-        const hash = convertHash(msg.AddFrontRequest);
+    // id 0 is valid, so check against undefined rather than truthiness
+    if (msg.AddFrontRequest !== undefined) {
+        const id = msg.AddFrontRequest;
 
-        console.log(`add front request identified! hash to add: ${hash}`);
+        console.log(`add front request identified! id to add: ${id}`);
 
-        const frontable = cache.getFrontable(hash);
+        const frontable = cache.getFrontableById(id);
         if (frontable) {
             console.log(`Adding frontable ${frontable.name} to front...`);
             currentFronterUids.push(frontable.apiUid);
             frontersModified = true;
         } else {
-            console.error(`Cannot add member to front! Member hash ${hash} was not cached!`);
+            console.error(`Cannot add member to front! Member id ${id} was not cached!`);
         }
     }
 
-    if (msg.SetFrontRequest) {
-        // re-offset hash to ensure full unsigned range
-        const hash = convertHash(msg.SetFrontRequest);
+    if (msg.SetFrontRequest !== undefined) {
+        const id = msg.SetFrontRequest;
 
-        console.log(`set front request identified! hash to set: ${hash}`);
+        console.log(`set front request identified! id to set: ${id}`);
 
-        const frontable = cache.getFrontable(hash);
+        const frontable = cache.getFrontableById(id);
         if (frontable) {
             console.log(`Setting frontable ${frontable.name} as front...`);
             currentFronterUids = [frontable.apiUid];
             frontersModified = true;
         } else {
-            console.error(`Cannot set member as front! Member hash ${hash} was not cached!`);
+            console.error(`Cannot set member as front! Member id ${id} was not cached!`);
         }
     }
 
-    if (msg.RemoveFrontRequest) {
-        // re-offset hash to ensure full unsigned range
-        const hash = convertHash(msg.RemoveFrontRequest);
+    if (msg.RemoveFrontRequest !== undefined) {
+        const id = msg.RemoveFrontRequest;
 
-        console.log(`remove front request identified! hash to remove: ${hash}`);
+        console.log(`remove front request identified! id to remove: ${id}`);
 
-        const frontable = cache.getFrontable(hash);
+        const frontable = cache.getFrontableById(id);
         if (frontable) {
             console.log(`Removing frontable ${frontable.name} from front...`);
 
@@ -282,36 +483,116 @@ Pebble.addEventListener("appmessage", async (e) => {
             frontersModified = true;
 
         } else {
-            console.error(`Cannot remove member from front! Member hash ${hash} was not cached!`);
+            console.error(`Cannot remove member from front! Member id ${id} was not cached!`);
+        }
+    }
+
+    // a whole list of fronters at once, multi-select and group fronting
+    //   send these so they turn into a single switch
+    if (msg.SetFrontListRequest !== undefined) {
+        const ids = utils.fromShortByteArray(msg.SetFrontListRequest);
+
+        console.log(`set front list request identified! ids to set: ${ids}`);
+
+        const uids: string[] = [];
+        for (const id of ids) {
+            const frontable = cache.getFrontableById(id);
+            if (frontable) {
+                uids.push(frontable.apiUid);
+            } else {
+                console.error(`Cannot set member as front! Member id ${id} was not cached!`);
+            }
+        }
+
+        if (uids.length > 0) {
+            currentFronterUids = uids;
+            frontersModified = true;
         }
     }
 
     if (frontersModified) {
-        console.log("Fronters modified... caching and setting new frontable list to this: ", currentFronterUids);
+        console.log("Fronters modified... queueing and setting new frontable list to this: ", currentFronterUids);
 
+        // queued first so nothing is lost if this fails, a switch that's
+        //   still waiting gets replaced rather than sent twice
+        cache.queueSwitch(currentFronterUids);
+
+        if (cache.getSystemId()) {
+            // a replay that's already running picks this up before it finishes
+            replayPendingSwitch(backend);
+        } else {
+            console.warn("WARNING: cannot set new fronters yet, system ID was not cached! switch stays queued...");
+        }
+    }
+
+    // sent by the watch after a reconnect, fronters always get
+    //   refreshed but everything else only if the watch fell behind
+    if (msg.CatchUpRequest !== undefined) {
         const uid = cache.getSystemId();
         if (uid) {
-            backend.endpoints.fetchSetCurrentFronters(uid, currentFronterUids)
-                .then((entries) => {
-                    if (entries !== undefined) {
-                        cache.cacheCurrentFronts(entries);
-                        messaging.sendCurrentFrontersToWatch(entries);
+            (async () => {
+                try {
+                    if (msg.CatchUpRequest !== cache.getDataRevision()) {
+                        console.log("Watch data is behind, re-sending cached data...");
+                        await fetchAndSendAllData(backend, uid, refresh.ALL_CACHED);
                     } else {
-                        console.warn("WARNING: backend set fronters replied with undefined!!");
+                        console.log("Watch data is up to date, only sending fronters...");
+                        const entries = await fetchAndSendCurrentFronts(backend, uid);
+                        await messaging.sendCurrentFrontersToWatch(entries, cache.getFrontableIds() ?? []);
                     }
-                });
+                } catch {
+                    console.error("ERROR: catch up failed from appmessage event!");
+                }
+            })();
         } else {
-            console.warn("WARNING: cannot set new fronters, system ID was not cached!");
+            console.warn("WARNING: cannot catch watch up, system ID was not cached!");
+        }
+    }
+
+    // sent by the watch after a sync whenever what it could fit changed,
+    //   only applies from the next sync since the watch already trimmed this one
+    if (msg.DataLimitLevel !== undefined && msg.DataLimitMaxFrontables !== undefined) {
+        console.log(`data limits identified! level: ${msg.DataLimitLevel}, max frontables: ${msg.DataLimitMaxFrontables}`);
+        cache.cacheDataLimits({
+            level: msg.DataLimitLevel,
+            maxFrontables: msg.DataLimitMaxFrontables,
+        });
+    }
+
+    // only sent by debug builds of the watch, from the heap stats screen
+    if (msg.HeapStats !== undefined) {
+        const values = utils.fromByteArray(msg.HeapStats);
+
+        console.log(`watch heap stats! free now: ${values[0]}, lowest free: ${values[1]}`);
+        HEAP_TAG_NAMES.forEach((name, i) => {
+            const [live, peak, allocs, failed] = values.slice(2 + i * 4, 2 + (i + 1) * 4);
+            console.log(`  ${name}: ${live} live, ${peak} peak, ${allocs} allocs, ${failed} failed`);
+        });
+    }
+
+    // sent by debug builds of the watch from settings, or in reply to a
+    //   TraceDumpRequest. times are ms since the watch's first event
+    if (msg.TraceDump !== undefined) {
+        console.log("watch sync trace!");
+
+        let prevTime: number | null = null;
+        for (let i = 0; i + 7 < msg.TraceDump.length; i += 8) {
+            const [time] = utils.fromByteArray(msg.TraceDump.slice(i, i + 4));
+            const [arg] = utils.fromShortByteArray(msg.TraceDump.slice(i + 4, i + 6));
+            const name = TRACE_EVENT_NAMES[msg.TraceDump[i + 6]] ?? `event ${msg.TraceDump[i + 6]}`;
+
+            const delta = prevTime !== null ? ` (+${time - prevTime}ms)` : "";
+            console.log(`  ${time}ms${delta}: ${name} [${arg}]`);
+            prevTime = time;
         }
     }
 
     if (msg.FetchDataRequest) {
         const uid = cache.getSystemId();
         if (uid) {
-            cache.cachePrevFetchTime(Date.now());
             (async () => {
                 try {
-                    await fetchAndSendAllData(backend, uid, false);
+                    await fetchAndSendAllData(backend, uid, refresh.NONE_CACHED);
                 } catch {
                     console.error("ERROR: fetchAndSendAllData failed from appmessage event!");
                     await messaging.sendErrorMessage("Unknown fetch error!");
@@ -368,9 +649,8 @@ Pebble.addEventListener("webviewclosed", async (e: any) => {
 
             const uid = cache.getSystemId();
             if (uid) {
-                cache.cachePrevFetchTime(Date.now());
                 try {
-                    await fetchAndSendAllData(backend, uid, false);
+                    await fetchAndSendAllData(backend, uid, refresh.NONE_CACHED);
                 } catch (err) {
                     console.error(`ERROR: fetchAndSendAllData failed from webviewclosed event! err: "${err}"`);
                     await messaging.sendErrorMessage("Unknown crash/error!");
@@ -380,6 +660,14 @@ Pebble.addEventListener("webviewclosed", async (e: any) => {
             }
         }
 
+        // cached after the token since a new token clears everything,
+        //   empty is a valid value here (it turns pushing off)
+        const grabbedRelayUrl: string | undefined = settingsDict.PushRelayUrl?.value;
+        if (grabbedRelayUrl !== undefined) {
+            cache.cachePushRelayUrl(grabbedRelayUrl.trim());
+        }
+        initPushChannel(backend);
+
         const msgDict = clay.getSettings(e.response, true);
 
         console.log(JSON.stringify(msgDict));
@@ -1,4 +1,4 @@
-import { AppMessageDesc, Frontable, FrontEntry, Group, Member } from "./types";
+import { AppMessageDesc, DataLimits, Frontable, FrontEntry, Group, Member, MemoryLevel } from "./types";
 import * as utils from "./utils";
 
 //! NOTE: make sure these match up with the #defines in 
@@ -15,10 +15,93 @@ const GROUP_LIST_MAX_COUNT = 32;
 // const GROUP_LIST_MAX_COUNT = 64;
 const DELIMETER = ';';
 const DEFAULT_COLOR = "#000000";
+const FULL_DATA: DataLimits = { level: MemoryLevel.Normal, maxFrontables: FRONTABLES_MAX_COUNT };
 
-function assembleFrontableMessages(frontables: Frontable[], groups: Group[]) {
-    const numFrontables = Math.min(frontables.length, FRONTABLES_MAX_COUNT);
+const GROUP_BIT_FIELDS = Math.ceil(GROUP_LIST_MAX_COUNT / 32);
+
+// a frontable's strings and color as they go over the wire
+interface EncodedFrontable {
+    // everything the encoding came from, it's stale once this changes
+    source: string;
+    name: string;
+    pronouns: string;
+    color: number;
+}
+
+// kept across syncs by uuid so members that didn't change aren't
+//   cleaned and converted again every time
+let encodedFrontables: { [apiUid: string]: EncodedFrontable } = {};
+
+function encodeFrontable(frontable: Frontable, sendPronouns: boolean): EncodedFrontable {
+    const member = frontable as Member;
+    const pronouns = (sendPronouns && member.pronouns) || "";
+    const color = frontable.color || DEFAULT_COLOR;
+    const source = `${frontable.name}\n${pronouns}\n${color}`;
+
+    const cached = encodedFrontables[frontable.apiUid];
+    if (cached && cached.source === source) {
+        return cached;
+    }
+
+    const encoded: EncodedFrontable = {
+        source,
+        name: utils.cleanString(frontable.name, FRONTABLE_NAME_LENGTH).replace(DELIMETER, "_"),
+        pronouns: utils.cleanString(pronouns, FRONTABLE_PRONOUNS_LENGTH).replace(DELIMETER, "_"),
+        color: utils.toARGB8Color(color),
+    };
+    encodedFrontables[frontable.apiUid] = encoded;
+
+    return encoded;
+}
+
+// group bit fields for every member uuid, built once per sync instead
+//   of searching every group's member list for every frontable
+function buildMembershipIndex(groups: Group[]): { [apiUid: string]: number[] } {
+    const index: { [apiUid: string]: number[] } = {};
+    const groupCount = Math.min(groups.length, GROUP_LIST_MAX_COUNT);
+
+    for (let g = 0; g < groupCount; g++) {
+        for (const apiUid of groups[g].memberUids) {
+            if (!index[apiUid]) {
+                index[apiUid] = new Array(GROUP_BIT_FIELDS).fill(0);
+            }
+
+            index[apiUid][Math.floor(g / 32)] |= (1 << (g % 32));
+        }
+    }
+
+    return index;
+}
+
+// low memory watches drop members off the end of the list
+function getMaxFrontables(limits: DataLimits): number {
+    return Math.min(FRONTABLES_MAX_COUNT, limits.maxFrontables);
+}
+
+// the watch knows frontables by their position in the list sent to it,
+//   this gives back the uuid behind every id so requests can be resolved
+export function getFrontableIdMap(frontables: Frontable[], limits: DataLimits = FULL_DATA): string[] {
+    return frontables
+        .slice(0, getMaxFrontables(limits))
+        .map(f => f.apiUid);
+}
+
+function assembleFrontableMessages(frontables: Frontable[], groups: Group[], limits: DataLimits) {
+    const numFrontables = Math.min(frontables.length, getMaxFrontables(limits));
+    const sendPronouns = limits.level < MemoryLevel.NoPronouns;
     const numMessages = Math.ceil(numFrontables / FRONTABLES_PER_MESSAGE);
+    const membership = buildMembershipIndex(groups);
+    const noGroups: number[] = new Array(GROUP_BIT_FIELDS).fill(0);
+
+    // whatever isn't sent this time doesn't need to stay encoded
+    const prevEncoded = encodedFrontables;
+    encodedFrontables = {};
+    for (let i = 0; i < numFrontables; i++) {
+        const apiUid = frontables[i].apiUid;
+        if (prevEncoded[apiUid]) {
+            encodedFrontables[apiUid] = prevEncoded[apiUid];
+        }
+    }
 
     const messages: AppMessageDesc[] = [];
 
@@ -31,62 +114,30 @@ function assembleFrontableMessages(frontables: Frontable[], groups: Group[]) {
         const pronounsArr: string[] = [];
         const colorsArr: number[] = [];
         const isCustomArr: boolean[] = [];
-        const hashesArr: number[] = [];
+        const idsArr: number[] = [];
         const groupBitArr: number[] = [];
 
-        toSend.forEach((frontable) => {
-            const member = frontable as Member;
-
-            // store pronouns
-            let pronouns = "";
-            if (member.pronouns) {
-                pronouns = utils.cleanString(member.pronouns, FRONTABLE_PRONOUNS_LENGTH);
-            }
-            pronounsArr.push(pronouns);
-
-            // store name
-            let name = utils.cleanString(frontable.name, FRONTABLE_NAME_LENGTH);
-            namesArr.push(name);
-
-            // store colors
-            let color = DEFAULT_COLOR;
-            if (frontable.color) {
-                color = frontable.color;
-            }
-            colorsArr.push(utils.toARGB8Color(color));
+        toSend.forEach((frontable, j) => {
+            // store name, pronouns and colors
+            const encoded = encodeFrontable(frontable, sendPronouns);
+            namesArr.push(encoded.name);
+            pronounsArr.push(encoded.pronouns);
+            colorsArr.push(encoded.color);
 
             // store is custom
             isCustomArr.push(frontable.isCustom);
 
-            // store hashes
-            hashesArr.push(frontable.hash);
-
-            // make and store bit fields dynamically
-            //   (hardcoding 32 bit integers here)
-            const numBitFields = Math.ceil(GROUP_LIST_MAX_COUNT / 32);
-            const groupCount = Math.min(groups.length, GROUP_LIST_MAX_COUNT);
-            for (let i = 0; i < numBitFields; i++) {
-                let bitField = 0;
-
-                if (groups) {
-                    // iterate from the current 32 bits to the next 32 bits
-                    for (let j = (i * 32); j < ((i + 1) * 32); j++) {
-                        if (j >= groupCount) break;
-
-                        if (groups[j].memberHashes.find(m => m === frontable.hash)) {
-                            bitField |= (1 << (j % 32));
-                        }
-                    }
-                }
+            // store ids, just the position in the sent list
+            idsArr.push(i * FRONTABLES_PER_MESSAGE + j);
 
-                groupBitArr.push(bitField);
-            }
+            // store bit fields (hardcoding 32 bit integers here)
+            groupBitArr.push(...(membership[frontable.apiUid] ?? noGroups));
         });
 
         const msg: AppMessageDesc = {
-            FrontableHash: utils.toByteArray(hashesArr),
-            FrontableName: namesArr.map(n => n.replace(DELIMETER, "_")).join(DELIMETER),
-            FrontablePronouns: pronounsArr.map(p => p.replace(DELIMETER, "_")).join(DELIMETER),
+            FrontableId: utils.toShortByteArray(idsArr),
+            FrontableName: namesArr.join(DELIMETER),
+            FrontablePronouns: pronounsArr.join(DELIMETER),
             FrontableIsCustom: isCustomArr.map(c => c ? 1 : 0),
             FrontableColor: colorsArr,
             FrontableGroupBitField: utils.toByteArray(groupBitArr),
@@ -114,7 +165,11 @@ function assembleGroupMessages(groups: Group[]) {
     const numGroups = Math.min(groups.length, GROUP_LIST_MAX_COUNT);
     const numMessages = Math.ceil(numGroups / GROUPS_PER_MESSAGE);
 
-    const groupsOriginal: Group[] = JSON.parse(JSON.stringify(groups));
+    // where every group id is in the list, parents are looked up by id
+    const groupIndices: { [id: string]: number } = {};
+    for (let j = 0; j < numGroups && j < 255; j++) {
+        groupIndices[groups[j].id] = j;
+    }
 
     const messages: AppMessageDesc[] = [];
 
@@ -139,17 +194,8 @@ function assembleGroupMessages(groups: Group[]) {
             }
             colorsArr.push(utils.toARGB8Color(color));
 
-            // store parent indices
-            let index = -1;
-            for (let j = 0; j < numGroups; j++) {
-                // don't use indices that won't fit in 8 bits
-                if (j >= 255) break;
-
-                if (group.parent === groupsOriginal[j].id) {
-                    index = j;
-                    break;
-                }
-            }
+            // store parent indices, indices that won't fit in 8 bits aren't in the map
+            const index = groupIndices[group.parent] ?? -1;
 
             // +1 the index so we can fit negative 1 within an unsigned int
             parentIndicesArr.push(index + 1);
@@ -182,7 +228,10 @@ function assembleGroupMessages(groups: Group[]) {
     return messages;
 }
 
-function assembleCurrentFrontMessages(currentFronters: FrontEntry[]) {
+function assembleCurrentFrontMessages(currentFronters: FrontEntry[], idMap: string[]) {
+    // fronters the watch was never sent have no id, leave them out
+    currentFronters = currentFronters.filter(entry => idMap.indexOf(entry.frontableApiUid) >= 0);
+
     const numFronters = Math.min(currentFronters.length, FRONTABLES_MAX_COUNT);
     const numMessages = Math.ceil(numFronters / CURRENT_FRONTS_PER_MESSAGE);
 
@@ -193,7 +242,7 @@ function assembleCurrentFrontMessages(currentFronters: FrontEntry[]) {
         const batchSize = Math.min(frontersRemaining, CURRENT_FRONTS_PER_MESSAGE);
         const toSend = currentFronters.splice(0, batchSize);
 
-        const hashes = utils.toByteArray(toSend.map(entry => entry.frontableHash));
+        const ids = utils.toShortByteArray(toSend.map(entry => idMap.indexOf(entry.frontableApiUid)));
 
         const times = utils.toByteArray(
             toSend.map(entry => {
@@ -207,7 +256,7 @@ function assembleCurrentFrontMessages(currentFronters: FrontEntry[]) {
         );
 
         const msg: AppMessageDesc = {
-            CurrentFronter: hashes,
+            CurrentFronter: ids,
             CurrentFrontStartTime: times,
             NumCurrentFrontersInBatch: batchSize
         };
@@ -230,7 +279,7 @@ function assembleCurrentFrontMessages(currentFronters: FrontEntry[]) {
 }
 
 export async function sendFrontablesToWatch(frontables: Frontable[], groups: Group[]): Promise<void> {
-    const messages = assembleFrontableMessages(frontables, groups);
+    const messages = assembleFrontableMessages(frontables, groups, FULL_DATA);
 
     for (let msg of messages) {
         await (PebbleTS.sendAppMessage(msg)
@@ -241,8 +290,8 @@ export async function sendFrontablesToWatch(frontables: Frontable[], groups: Gro
     }
 }
 
-export async function sendCurrentFrontersToWatch(currentFronters: FrontEntry[]): Promise<void> {
-    const messages = assembleCurrentFrontMessages(currentFronters);
+export async function sendCurrentFrontersToWatch(currentFronters: FrontEntry[], idMap: string[]): Promise<void> {
+    const messages = assembleCurrentFrontMessages(currentFronters, idMap);
 
     for (let msg of messages) {
         await PebbleTS.sendAppMessage(msg)
@@ -269,15 +318,28 @@ export async function sendDataBatchToWatch(
     frontables: Frontable[],
     currentFronters: FrontEntry[],
     groups: Group[],
+    idMap: string[],
+    revision: number,
+    limits: DataLimits,
 ): Promise<void> {
     const messages: AppMessageDesc[] = [];
 
+    // what the batch would be without any limits, the watch sizes its
+    //   memory level off this so a trimmed batch doesn't look like it fits
+    const fullFrontables = Math.min(frontables.length, FRONTABLES_MAX_COUNT);
+    const fullGroups = Math.min(groups.length, GROUP_LIST_MAX_COUNT);
+
+    // watches too low on memory for group menus don't get groups at all
+    if (limits.level >= MemoryLevel.NoGroups) {
+        groups = [];
+    }
+
     // assemble and merge frontable messages
-    const frontableMessages = assembleFrontableMessages(frontables, groups);
+    const frontableMessages = assembleFrontableMessages(frontables, groups, limits);
     messages.push(...frontableMessages);
 
     // assemble and merge all current frontable message data
-    const currentFronterMessages = assembleCurrentFrontMessages(currentFronters);
+    const currentFronterMessages = assembleCurrentFrontMessages(currentFronters, idMap);
     for (let i = 0; i < currentFronterMessages.length; i++) {
         if (i >= messages.length) {
             messages.push(currentFronterMessages[i]);
@@ -297,6 +359,13 @@ export async function sendDataBatchToWatch(
         }
     }
 
+    // the watch only takes on the revision once the whole batch is in
+    if (messages.length > 0) {
+        messages[0].DataRevision = revision;
+        messages[0].DataFullFrontables = fullFrontables;
+        messages[0].DataFullGroups = fullGroups;
+    }
+
     // take all the merged data and send it all :D
     for (let msg of messages) {
         await PebbleTS.sendAppMessage(msg);
@@ -0,0 +1,82 @@
+// push channel over a websocket relay, backends that can't be reached
+//   from the phone directly (like webhooks) get their events forwarded
+//   through one of these so fronters update without polling
+
+import { PushChannel, PushHandlers } from "./types";
+
+const RECONNECT_BASE_MS = 2 * 1000;
+const RECONNECT_MAX_MS = 5 * 60 * 1000;
+
+/**
+ * Creates a push channel that listens to a relay for backend events
+ * @param isFrontEvent Takes a parsed relay message and the system's uid,
+ *   true if it means the system's fronters changed
+ */
+export function createRelayChannel(isFrontEvent: (event: any, uid: string) => boolean): PushChannel {
+    let socket: WebSocket | null = null;
+    let reconnectTimer: ReturnType<typeof setTimeout> | null = null;
+    let reconnectAttempt = 0;
+
+    function disconnect() {
+        if (reconnectTimer !== null) {
+            clearTimeout(reconnectTimer);
+            reconnectTimer = null;
+        }
+
+        if (socket) {
+            // cleared first so closing on purpose doesn't reconnect
+            const closing = socket;
+            socket = null;
+            closing.close();
+        }
+    }
+
+    function connect(uid: string, relayUrl: string | null, handlers: PushHandlers) {
+        disconnect();
+
+        if (!relayUrl) {
+            console.log("No push relay set, fronters only update by polling!");
+            return;
+        }
+
+        const opened = new WebSocket(relayUrl);
+        socket = opened;
+
+        opened.onopen = () => {
+            console.log(`push relay connected! (${relayUrl})`);
+            reconnectAttempt = 0;
+        };
+
+        opened.onmessage = (e: MessageEvent) => {
+            try {
+                if (isFrontEvent(JSON.parse(e.data), uid)) {
+                    handlers.onFrontersChanged();
+                }
+            } catch (err) {
+                console.warn(`WARNING: ignoring unreadable push relay message! err: "${err}"`);
+            }
+        };
+
+        opened.onclose = () => {
+            if (socket !== opened) {
+                return;
+            }
+
+            // jittered so a relay restart doesn't get every phone back at once
+            const cap = Math.min(RECONNECT_MAX_MS, RECONNECT_BASE_MS * Math.pow(2, reconnectAttempt++));
+            const delay = cap / 2 + Math.random() * cap / 2;
+            console.warn(`WARNING: push relay closed, reconnecting in ${Math.round(delay)}ms...`);
+
+            socket = null;
+            reconnectTimer = setTimeout(() => {
+                reconnectTimer = null;
+                connect(uid, relayUrl, handlers);
+            }, delay);
+        };
+    }
+
+    return {
+        connect,
+        disconnect,
+    };
+}
@@ -0,0 +1,81 @@
+// adaptive refresh schedule for the big datasets, fronters are always
+//   fetched but members and groups only when they're due. every fetch
+//   that finds changes tightens the interval, every one that doesn't
+//   backs it off, up to the user's fetch interval
+
+import * as cache from "./cache";
+
+export enum Dataset {
+    Frontables = "frontables",
+    Groups = "groups",
+}
+
+export interface DatasetSchedule {
+    lastFetch: number;
+    interval: number;
+}
+
+// which datasets can come from cache instead of the api
+export interface CachePolicy {
+    frontables: boolean;
+    groups: boolean;
+}
+
+export const ALL_CACHED: CachePolicy = Object.freeze({ frontables: true, groups: true });
+export const NONE_CACHED: CachePolicy = Object.freeze({ frontables: false, groups: false });
+
+const MIN_INTERVAL_MS = 1000 * 60 * 60;
+// (24h in MS is a fallback)
+const DEFAULT_MAX_INTERVAL_MS = (1000 * 60 * 60) * 24;
+// a change cuts the interval harder than a quiet fetch grows it,
+//   edits tend to come in bursts
+const TIGHTEN_DIVISOR = 4;
+const BACKOFF_FACTOR = 2;
+
+function getMaxInterval(): number {
+    return Math.max(cache.getFetchInterval() ?? DEFAULT_MAX_INTERVAL_MS, MIN_INTERVAL_MS);
+}
+
+function isDue(dataset: Dataset, time: number): boolean {
+    const schedule = cache.getRefreshSchedule()[dataset];
+    if (!schedule) {
+        return true;
+    }
+
+    // the user's interval can shrink after it was learned
+    const interval = Math.min(schedule.interval, getMaxInterval());
+    return time - schedule.lastFetch >= interval;
+}
+
+/**
+ * Gets which datasets are fresh enough to be used from cache right now
+ */
+export function getScheduledPolicy(): CachePolicy {
+    const time = Date.now();
+    const policy = {
+        frontables: !isDue(Dataset.Frontables, time),
+        groups: !isDue(Dataset.Groups, time),
+    };
+
+    console.log(`refresh policy: frontables ${policy.frontables ? "cached" : "due"}, groups ${policy.groups ? "cached" : "due"}`);
+    return policy;
+}
+
+/**
+ * Records a fetch of a dataset from the api and adjusts when it's due next
+ * @param changed Whether the fetched data differed from what was cached
+ */
+export function recordFetch(dataset: Dataset, changed: boolean) {
+    const schedules = cache.getRefreshSchedule();
+    const maxInterval = getMaxInterval();
+    const prevInterval = schedules[dataset]?.interval ?? maxInterval;
+
+    const interval = changed
+        ? Math.max(MIN_INTERVAL_MS, prevInterval / TIGHTEN_DIVISOR)
+        : Math.min(maxInterval, prevInterval * BACKOFF_FACTOR);
+
+    schedules[dataset] = { lastFetch: Date.now(), interval };
+    cache.cacheRefreshSchedule(schedules);
+
+    console.log(`${dataset} ${changed ? "changed" : "unchanged"}, next fetch in ${Math.round(interval / 1000 / 60)}min`);
+}
@@ -0,0 +1,290 @@
+// request scheduler, every backend call goes through one of these so
+//   bursts get spread out under the backend's rate limits instead of
+//   bouncing off them with 429s
+
+import * as utils from "./utils";
+
+export interface RateLimits {
+    // token bucket refill rates, reads are GETs and writes are the rest
+    readsPerSecond: number;
+    writesPerSecond: number;
+    // how many tokens a bucket can save up for bursts
+    burst: number;
+    maxInFlight: number;
+    timeoutMs: number;
+    // retries after the first attempt, only for 429s, plus 5xx and
+    //   network errors on GETs
+    maxRetries: number;
+    // how long a finished GET keeps answering identical GETs, 0 to only
+    //   share ones that are still in flight
+    settleMs: number;
+}
+
+export interface EndpointStats {
+    requests: number;
+    errors: number;
+    retries: number;
+    totalLatencyMs: number;
+    maxLatencyMs: number;
+}
+
+export interface Scheduler {
+    fetch: <T = any>(routeDesc: utils.RouteDescription) => Promise<utils.FetchResult<T>>;
+    getStats: () => { [endpoint: string]: EndpointStats };
+    logStats: () => void;
+    // forgets finished GETs so the next ones hit the backend
+    invalidate: () => void;
+}
+
+type Transport = <T>(routeDesc: utils.RouteDescription) => Promise<utils.FetchResult<T>>;
+
+interface TokenBucket {
+    tokens: number;
+    perSecond: number;
+    lastRefill: number;
+}
+
+interface QueuedRequest {
+    routeDesc: utils.RouteDescription;
+    run: () => void;
+}
+
+interface SharedRequest {
+    promise: Promise<utils.FetchResult<any>>;
+    // when the request finished, undefined while still in flight
+    settledAt?: number;
+}
+
+const BACKOFF_BASE_MS = 500;
+const BACKOFF_MAX_MS = 30 * 1000;
+
+function isRetryable(routeDesc: utils.RouteDescription, err: utils.FetchError): boolean {
+    // a 429 was never processed, so anything can go again
+    if (err.status === 429) {
+        return true;
+    }
+
+    // a write that failed any other way might have gone through anyways,
+    //   retrying could apply it twice (callers reconcile those themselves)
+    if (routeDesc.method !== "GET") {
+        return false;
+    }
+
+    // no status means it never got an answer (network error or timeout)
+    return err.status === undefined || err.status >= 500;
+}
+
+// full jitter, a random wait up to the exponential cap so retries
+//   from a burst don't all land at the same time again
+function getBackoffMs(attempt: number): number {
+    const cap = Math.min(BACKOFF_MAX_MS, BACKOFF_BASE_MS * Math.pow(2, attempt));
+    return Math.random() * cap;
+}
+
+function wait(ms: number): Promise<void> {
+    return new Promise(resolve => setTimeout(resolve, ms));
+}
+
+// counters are keyed by method and url path, with anything that looks
+//   like an id collapsed so every group/member lands on the same key
+function getEndpointName(routeDesc: utils.RouteDescription): string {
+    const path = routeDesc.url
+        .replace(/^[a-z]+:\/\/[^/]+/i, "")
+        .replace(/\?.*$/, "")
+        .split("/")
+        .map(part => /\d/.test(part) && part.length > 4 ? ":id" : part)
+        .join("/");
+
+    return `${routeDesc.method} ${path}`;
+}
+
+// the token is part of it so a new token never gets an old token's answer
+function getSharedKey(routeDesc: utils.RouteDescription): string {
+    return `${routeDesc.method} ${routeDesc.url} ${routeDesc.auth?.token ?? ""}`;
+}
+
+export function createScheduler(limits: RateLimits, transport: Transport = utils.fetch): Scheduler {
+    const now = Date.now();
+    const buckets: { read: TokenBucket, write: TokenBucket } = {
+        read: { tokens: limits.burst, perSecond: limits.readsPerSecond, lastRefill: now },
+        write: { tokens: limits.burst, perSecond: limits.writesPerSecond, lastRefill: now },
+    };
+
+    const queue: QueuedRequest[] = [];
+    const stats: { [endpoint: string]: EndpointStats } = {};
+    // identical GETs share one request, see fetch
+    let shared: { [key: string]: SharedRequest } = {};
+    let inFlight = 0;
+    // set from Retry-After, nothing is sent until then
+    let pausedUntil = 0;
+    let pumpTimer: ReturnType<typeof setTimeout> | null = null;
+
+    function getBucket(routeDesc: utils.RouteDescription): TokenBucket {
+        return routeDesc.method === "GET" ? buckets.read : buckets.write;
+    }
+
+    function refill(bucket: TokenBucket, time: number) {
+        const elapsed = (time - bucket.lastRefill) / 1000;
+        bucket.tokens = Math.min(limits.burst, bucket.tokens + elapsed * bucket.perSecond);
+        bucket.lastRefill = time;
+    }
+
+    function schedulePump(delayMs: number) {
+        if (pumpTimer !== null) {
+            return;
+        }
+
+        pumpTimer = setTimeout(() => {
+            pumpTimer = null;
+            pump();
+        }, Math.max(delayMs, 0));
+    }
+
+    // starts as many queued requests as the limits allow, in order
+    function pump() {
+        while (queue.length > 0 && inFlight < limits.maxInFlight) {
+            const time = Date.now();
+            if (time < pausedUntil) {
+                schedulePump(pausedUntil - time);
+                return;
+            }
+
+            const bucket = getBucket(queue[0].routeDesc);
+            refill(bucket, time);
+            if (bucket.tokens < 1) {
+                schedulePump(((1 - bucket.tokens) / bucket.perSecond) * 1000);
+                return;
+            }
+
+            bucket.tokens -= 1;
+            inFlight++;
+            queue.shift()!.run();
+        }
+    }
+
+    // resolves once the request is allowed to go out
+    function acquire(routeDesc: utils.RouteDescription): Promise<void> {
+        return new Promise(resolve => {
+            queue.push({ routeDesc, run: resolve });
+            pump();
+        });
+    }
+
+    function release() {
+        inFlight--;
+        pump();
+    }
+
+    function getEndpointStats(endpoint: string): EndpointStats {
+        if (!stats[endpoint]) {
+            stats[endpoint] = { requests: 0, errors: 0, retries: 0, totalLatencyMs: 0, maxLatencyMs: 0 };
+        }
+
+        return stats[endpoint];
+    }
+
+    async function request<T>(routeDesc: utils.RouteDescription): Promise<utils.FetchResult<T>> {
+        const endpointStats = getEndpointStats(getEndpointName(routeDesc));
+        const timedDesc = { ...routeDesc, timeoutMs: routeDesc.timeoutMs ?? limits.timeoutMs };
+
+        for (let attempt = 0; ; attempt++) {
+            await acquire(routeDesc);
+
+            const start = Date.now();
+            endpointStats.requests++;
+
+            try {
+                const result = await transport<T>(timedDesc);
+                const latency = Date.now() - start;
+                endpointStats.totalLatencyMs += latency;
+                endpointStats.maxLatencyMs = Math.max(endpointStats.maxLatencyMs, latency);
+                release();
+
+                return result;
+            } catch (e) {
+                const err = e as utils.FetchError;
+                endpointStats.errors++;
+
+                let delay = getBackoffMs(attempt);
+                if (err.retryAfterMs !== undefined) {
+                    // the backend said how long it wants, hold everything else too
+                    delay = Math.max(delay, err.retryAfterMs);
+                    pausedUntil = Math.max(pausedUntil, Date.now() + err.retryAfterMs);
+                }
+
+                release();
+
+                if (attempt >= limits.maxRetries || !isRetryable(routeDesc, err)) {
+                    throw err;
+                }
+
+                console.warn(`WARNING: ${routeDesc.method} ${routeDesc.url} failed (${err.message}), retrying in ${Math.round(delay)}ms...`);
+                endpointStats.retries++;
+                await wait(delay);
+            }
+        }
+    }
+
+    // forgets finished GETs past the settle window, or all of them
+    function dropSettled(all: boolean) {
+        const time = Date.now();
+        for (const key in shared) {
+            const { settledAt } = shared[key];
+            if (settledAt !== undefined && (all || time - settledAt >= limits.settleMs)) {
+                delete shared[key];
+            }
+        }
+    }
+
+    // single-flight, concurrent identical GETs (and ones right after it
+    //   finished) all get the same promise instead of their own request.
+    //   any write can change what a GET returns, so it drops everything settled
+    function fetch<T = any>(routeDesc: utils.RouteDescription): Promise<utils.FetchResult<T>> {
+        if (routeDesc.method !== "GET") {
+            const promise = request<T>(routeDesc);
+            promise.then(() => dropSettled(true), () => dropSettled(true));
+            return promise;
+        }
+
+        dropSettled(false);
+
+        const key = getSharedKey(routeDesc);
+        if (shared[key]) {
+            return shared[key].promise;
+        }
+
+        const entry: SharedRequest = { promise: request<T>(routeDesc) };
+        shared[key] = entry;
+
+        entry.promise.then(
+            () => {
+                entry.settledAt = Date.now();
+            },
+            () => {
+                // failures are never reused, the next caller tries again
+                if (shared[key] === entry) {
+                    delete shared[key];
+                }
+            }
+        );
+
+        return entry.promise;
+    }
+
+    function logStats() {
+        for (const endpoint in stats) {
+            const { requests, errors, retries, totalLatencyMs, maxLatencyMs } = stats[endpoint];
+            // only successful requests have a latency recorded
+            const successes = requests - errors;
+            const avg = successes > 0 ? Math.round(totalLatencyMs / successes) : 0;
+            console.log(`${endpoint}: ${requests} requests, ${errors} errors, ${retries} retries, ${avg}ms avg, ${maxLatencyMs}ms max`);
+        }
+    }
+
+    return {
+        fetch,
+        getStats: () => stats,
+        logStats,
+        invalidate: () => dropSettled(true),
+    };
+}
@@ -92,9 +92,9 @@ export function sortGroups(groups: Group[], frontables: Frontable[]): Group[] {
     }
 
     // sort group children alphabetically
-    groups.forEach(g => g.memberHashes.sort((a, b) => {
-        const memberA = frontables.find(f => f.hash === a);
-        const memberB = frontables.find(f => f.hash === b);
+    groups.forEach(g => g.memberUids.sort((a, b) => {
+        const memberA = frontables.find(f => f.apiUid === a);
+        const memberB = frontables.find(f => f.apiUid === b);
 
         if (!memberA || !memberB) return 0;
 
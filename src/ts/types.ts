@@ -5,7 +5,6 @@ export interface Member {
     pronouns?: string;
     archived: boolean;
     apiUid: string;
-    hash: number;
     isCustom: false;
 };
 
@@ -14,34 +13,56 @@ export interface CustomFront {
     avatarUrl?: string;
     color?: string;
     apiUid: string;
-    hash: number;
     isCustom: true;
 };
 
 export interface FrontEntry {
     frontableApiUid: string;
-    frontableHash: number;
     startTime?: number;
     endTime?: number;
 };
 
 export type Frontable = Member | CustomFront;
 
+// a switch made on the watch that hasn't reached the backend yet,
+//   time is when it was made on this phone
+export interface PendingSwitch {
+    apiUids: string[];
+    time: number;
+};
+
 export interface Group {
     id: string;
     name: string;
     color?: string;
     parent: string;
-    memberHashes: number[];
+    memberUids: string[];
 };
 
 export enum ErrorCode {
     APIKeyInvalid = 1,
 };
 
+// make sure these match the MemoryLevel enum in memory_governor.h,
+//   every level also sheds everything before it
+export enum MemoryLevel {
+    Normal = 0,
+    NoPronouns = 1,
+    NoHiddenRoot = 2,
+    NoGroups = 3,
+    Truncated = 4,
+};
+
+// what the watch has room for, reported back after it sheds data
+export interface DataLimits {
+    level: MemoryLevel;
+    maxFrontables: number;
+};
+
 // describes all the message keys defined in package.json
 export interface AppMessageDesc {
     PluralApiKey?: string;
+    PushRelayUrl?: string;
     ApiKeyValid?: boolean;
     ErrorMessage?: string;
 
@@ -52,7 +73,7 @@ export interface AppMessageDesc {
 
     NumTotalFrontables?: number;
     NumFrontablesInBatch?: number;
-    FrontableHash?: number[];
+    FrontableId?: number[];
     FrontableName?: string;
     FrontableColor?: number[];
     FrontablePronouns?: string;
@@ -68,6 +89,16 @@ export interface AppMessageDesc {
     AddFrontRequest?: number;
     SetFrontRequest?: number;
     RemoveFrontRequest?: number;
+    SetFrontListRequest?: number[];
+    CatchUpRequest?: number;
+    DataRevision?: number;
+    DataLimitLevel?: number;
+    DataLimitMaxFrontables?: number;
+    DataFullFrontables?: number;
+    DataFullGroups?: number;
+    HeapStats?: number[];
+    TraceDumpRequest?: boolean;
+    TraceDump?: number[];
     FetchDataRequest?: boolean;
     ClearCacheRequest?: boolean;
 };
@@ -80,9 +111,15 @@ export interface EndpointImpl {
     fetchSetCurrentFronters: (uid: string, toSetApiUids: string[]) => Promise<FrontEntry[] | undefined>;
 };
 
-export interface SocketImpl {
-    onFrontUpdate: (newFronts: Frontable[]) => void;
-    onApiValid: (isValid: boolean) => void;
+export interface PushHandlers {
+    onFrontersChanged: () => void;
+};
+
+// events pushed from a backend instead of polled, relayUrl is where
+//   they get forwarded from and null leaves the channel disconnected
+export interface PushChannel {
+    connect: (uid: string, relayUrl: string | null, handlers: PushHandlers) => void;
+    disconnect: () => void;
 };
 
 export interface ConfigLayout {
@@ -102,12 +139,12 @@ export interface ConfigLayout {
     additionalItems?: object[];
 };
 
-// TODO: figure out how to implement a cached switch queueing system 
-//   (to avoid rate limiting for fast switches and other data fetching)
 export interface APIImpl {
     name: string;
     setToken: (token: string) => void;
     endpoints: EndpointImpl;
-    socket?: SocketImpl;
+    push?: PushChannel;
     configLayout: ConfigLayout;
+    // per-endpoint request counters from the backend's scheduler
+    logRequestStats?: () => void;
 }
@@ -1,25 +1,5 @@
 // utils file, holds a handful of utility functions
 
-// this is the Jenkins one-at-a-time hash function!
-//   https://en.wikipedia.org/wiki/Jenkins_hash_function
-//! NOTE: this may result in hash collisions, as far as I've tested 
-//!   there have been none but be aware in case of future issues
-export function genHash(str: string) {
-    let hash = 0;
-    for (var i = 0; i < str.length; i++) {
-        hash += str.charCodeAt(i);
-        hash += hash << 10;
-        hash ^= hash >> 6;
-    }
-
-    hash += hash << 3;
-    hash ^= hash << 11;
-    hash += hash << 15;
-
-    // zero-fill right shift to ensure unsigned
-    return (hash >>> 0) % 0xFFFFFFFF;
-}
-
 // converts an array of 32 bit integers into a quadruple-sized 8-bit 
 //   integer array containing all the bytes of the inputted array
 export function toByteArray(array: number[]): number[] {
@@ -35,6 +15,19 @@ export function toByteArray(array: number[]): number[] {
     return byteArr;
 }
 
+// converts an array of 16 bit integers into a double-sized 8-bit
+//   integer array, used for frontable ids
+export function toShortByteArray(array: number[]): number[] {
+    const byteArr: number[] = [];
+
+    for (const num of array) {
+        byteArr.push((num >>> 8) & 0xFF);
+        byteArr.push((num >>> 0) & 0xFF);
+    }
+
+    return byteArr;
+}
+
 // converts an array of 8-bit integers back into a quarter-sized
 //   32-bit integer array from the array of bytes
 export function fromByteArray(array: number[]): number[] {
@@ -53,6 +46,22 @@ export function fromByteArray(array: number[]): number[] {
     return outputArr;
 }
 
+// converts an array of 8-bit integers back into a half-sized
+//   16-bit integer array, used for frontable id lists from the watch
+export function fromShortByteArray(array: number[]): number[] {
+    const outputArr: number[] = [];
+
+    for (let i = 0; i + 1 < array.length; i += 2) {
+        let num = 0;
+        num |= ((array[i + 0] & 0xFF) << 8);
+        num |= ((array[i + 1] & 0xFF) << 0);
+
+        outputArr.push(num);
+    }
+
+    return outputArr;
+}
+
 export function toARGB8Color(hexCode: string): number {
     // input should be in RGBA format "#FF0e0FFF"
 
@@ -75,12 +84,34 @@ export function toARGB8Color(hexCode: string): number {
     return color;
 }
 
+// code units the code point at an index takes up, surrogate pairs are 2
+function codePointUnits(str: string, index: number): number {
+    const code = str.charCodeAt(index);
+    return (code >= 0xD800 && code <= 0xDBFF && index + 1 < str.length) ? 2 : 1;
+}
+
+// bytes the code point at an index takes up in UTF-8, which is what
+//   strings are on the wire and on the watch. lone surrogates count as
+//   the 3 byte replacement character they get encoded as
+function codePointByteLen(str: string, index: number): number {
+    const code = str.charCodeAt(index);
+    if (code < 0x80) return 1;
+    if (code < 0x800) return 2;
+    if (codePointUnits(str, index) === 2) return 4;
+    return 3;
+}
+
 export function calcByteLen(str: string): number {
     let len = 0;
-    Array.from(str).forEach(c => len += c.charCodeAt(0) > 255 ? 4 : 1);
+    for (let i = 0; i < str.length; i += codePointUnits(str, i)) {
+        len += codePointByteLen(str, i);
+    }
+
     return len;
 }
 
+// trims and cuts a string down to a UTF-8 byte budget in one pass,
+//   only ever between code points so nothing arrives half cut off
 export function cleanString(str: string, maxBytes: number): string {
     if (!str) {
         return "";
@@ -88,21 +119,20 @@ export function cleanString(str: string, maxBytes: number): string {
 
     str = str.trim();
 
-    let retStr = "";
     let numBytes = 0;
+    let end = 0;
+    while (end < str.length) {
+        const bytes = codePointByteLen(str, end);
+        if (numBytes + bytes > maxBytes) break;
 
-    Array.from(str).forEach(c => {
-        numBytes += calcByteLen(c);
-
-        if (numBytes <= maxBytes) {
-            retStr += c;
-        }
-    });
+        numBytes += bytes;
+        end += codePointUnits(str, end);
+    }
 
-    return retStr.trim();
+    return str.slice(0, end).trim();
 }
 
-interface RouteDescription {
+export interface RouteDescription {
     url: string;
     method: "GET" | "POST" | "PATCH" | "DELETE";
     body?: any;
@@ -110,9 +140,40 @@ interface RouteDescription {
         headerName: string;
         token: string;
     };
+    // 0 or missing waits forever
+    timeoutMs?: number;
 }
 
-export async function fetch<T = any>(routeDesc: RouteDescription): Promise<{ status: number, jsonData?: T }> {
+export interface FetchResult<T> {
+    status: number;
+    jsonData?: T;
+}
+
+// status is missing when there was no response at all
+export interface FetchError extends Error {
+    status?: number;
+    retryAfterMs?: number;
+}
+
+function createFetchError(message: string, status?: number, retryAfter?: string | null): FetchError {
+    const err = new Error(message) as FetchError;
+    err.status = status;
+
+    // either a number of seconds or an http date
+    if (retryAfter) {
+        const seconds = Number(retryAfter);
+        const ms = isNaN(seconds) ? Date.parse(retryAfter) - Date.now() : seconds * 1000;
+        if (!isNaN(ms)) {
+            err.retryAfterMs = Math.max(ms, 0);
+        }
+    }
+
+    return err;
+}
+
+// a single raw request, backends should go through a scheduler instead
+//   so they get rate limiting and retries
+export async function fetch<T = any>(routeDesc: RouteDescription): Promise<FetchResult<T>> {
     const xhr = await new Promise((resolve: (xhr: XMLHttpRequest) => void, reject) => {
         const xhr = new XMLHttpRequest();
 
@@ -120,13 +181,20 @@ export async function fetch<T = any>(routeDesc: RouteDescription): Promise<{ sta
             if (xhr.status >= 200 && xhr.status < 300) {
                 resolve(xhr);
             } else {
-                reject(new Error(`Request failed with status ${xhr.status}!`));
+                reject(createFetchError(
+                    `Request failed with status ${xhr.status}!`,
+                    xhr.status,
+                    xhr.getResponseHeader("Retry-After")
+                ));
             }
         };
-        xhr.onerror = () => reject(new Error("Network error!"));
-        xhr.ontimeout = () => reject(new Error("Fetch timeout!"));
+        xhr.onerror = () => reject(createFetchError("Network error!"));
+        xhr.ontimeout = () => reject(createFetchError("Fetch timeout!"));
 
         xhr.open(routeDesc.method, routeDesc.url, true);
+        if (routeDesc.timeoutMs) {
+            xhr.timeout = routeDesc.timeoutMs;
+        }
         if (routeDesc.auth) {
             // xhr.setRequestHeader("Authorization", token);
             const { headerName, token } = routeDesc.auth;